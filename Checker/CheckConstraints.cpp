@@ -5,58 +5,34 @@
 
 
 
-CheckConstraints::CheckConstraints(const pb::PCenter::Input &input_s, const pb::PCenter::Output &output_s) {
-    input = input_s;
-    output = output_s;
-}
-
 int CheckConstraints::generateNum() { // ȡڵ
-    vector<int> vec;
+    numOfNodes = 0;
     for (auto edge = input.graph().edges().begin(); edge != input.graph().edges().end(); ++edge) {
-        vec.push_back(edge->source());
-        vec.push_back(edge->target());
+        if ((edge->source() <= 0) || (edge->target() <= 0)) { return numOfNodes = -1; } // invalid node ID.
+        numOfNodes = max(numOfNodes, max(edge->source(), edge->target()));
     }
-    auto maxPosition = max_element(vec.begin(), vec.end());
-    numOfNodes = *maxPosition;
     return numOfNodes;
 }
 
-vector<vector<int>> CheckConstraints::generateGraph() { // ٽӱ
-    vector<vector<int>> G(numOfNodes, vector<int>(numOfNodes, INF));
-    for (auto edge = input.graph().edges().begin(); edge != input.graph().edges().end(); ++edge) {
-        int source = edge->source();
-        int target = edge->target();
-        int length = edge->length();
-        G[source - 1][target - 1] = length;
-        G[target - 1][source - 1] = length;
-    }
-    for (int i = 0; i < numOfNodes; ++i) {
-        G[i][i] = 0;
-    }
-    return G;
+void CheckConstraints::generateCsr(Csr &csr) const {
+    const auto &edges(input.graph().edges());
+    buildCsr(numOfNodes, edges.size(), [&](int e, int &source, int &target, int &length) {
+        source = edges[e].source() - 1;
+        target = edges[e].target() - 1;
+        length = edges[e].length();
+    }, csr);
 }
 
-int CheckConstraints::generateMaxLength() {
-    vector<vector<int>> G = generateGraph();
+int CheckConstraints::checkCenters(vector<int> &centers) {
     numOfCenters = input.centernum();
+    return checkCenters(numOfNodes, numOfCenters, output.centers().begin(), output.centers().end(), centers);
+}
+
+int CheckConstraints::generateMaxLength() {
     vector<int> centers;
-    vector<vector<int>> distance(numOfCenters, vector<int>(numOfNodes)); // зڵ㵽ڵľ
-    for (int i = 0; i < numOfCenters; ++i) {
-        centers.push_back(output.centers(i));
-        distance[i] = Dijkstra(numOfNodes, output.centers(i), G);
-    }
-    vector<int> serveLength;
-    for (int i = 0; i < numOfNodes; ++i) {
-        if (find(centers.begin(), centers.end(), i + 1) == centers.end()) { // ֻûڵ
-            vector<int> length(numOfCenters);
-            for (int j = 0; j < numOfCenters; ++j) {
-                length[j] = distance[j][i];
-            }
-            auto minPosition = min_element(length.begin(), length.end());
-            serveLength.push_back(*minPosition); // ߵĳ
-        }
-    }
-    auto maxPosition = max_element(serveLength.begin(), serveLength.end()); // еֵ
-    maxLength = *maxPosition;
+    if ((numOfNodes <= 0) || (checkCenters(centers) != 0)) { return maxLength = -1; }
+    Csr csr;
+    generateCsr(csr);
+    maxLength = multiSourceMaxLength(numOfNodes, csr.offsets.data(), csr.nodes.data(), csr.lengths.data(), centers);
     return maxLength;
 }
@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <iostream>
+#include <functional>
+#include <queue>
+#include <utility>
 #include"../Solver/PCenter.pb.h"
 
 using namespace std;
@@ -12,50 +15,109 @@ const int INF = INT32_MAX;
 
 class CheckConstraints {
 public:
+    enum ErrorFlag {
+        IoError = 0x0,
+        FormatError = 0x1,
+        CenterRepeatedError = 0x2,
+    };
+
+    // compressed sparse row of an undirected graph. the adjacent nodes of node i are in [offsets[i], offsets[i + 1]).
+    struct Csr {
+        vector<int> offsets;
+        vector<int> nodes;
+        vector<int> lengths;
+    };
+
     int numOfNodes = 0;
     int numOfCenters = 0;
     int maxLength = 0;
-    pb::PCenter::Input input;
-    pb::PCenter::Output output;
+    const pb::PCenter::Input &input; // borrowed, so it should outlive the checker.
+    const pb::PCenter::Output &output; // borrowed, so it should outlive the checker.
 
 public:
-    CheckConstraints(const pb::PCenter::Input &input_s, const pb::PCenter::Output &output_s);
+    CheckConstraints(const pb::PCenter::Input &input_s, const pb::PCenter::Output &output_s) : input(input_s), output(output_s) {}
 
 public:
-    static vector<int> Dijkstra(int n, int s, vector<vector<int>> &G) {
-        vector<int> d(n, INF); // ʼ̾ȫΪINF
-        vector<bool> vis(n); // ǽڵǷ񱻷
-        vector<int> pre(n); // ·һڵ
-        for (int i = 0; i < n; ++i)
-            pre[i] = i;
-
-        d[s] = 0;
-        for (int i = 0; i < n; ++i) {
-            int u = -1;
-            int MIN = INF;
-            for (int j = 0; j < n; ++j) {
-                if (vis[j] == false && d[j] < MIN) {
-                    u = j;
-                    MIN = d[j];
+    // edge(e, source, target, length) gives the zero-based end nodes and the length of edge e.
+    template<typename EdgeAccessor>
+    static void buildCsr(int nodeNum, int edgeNum, EdgeAccessor edge, Csr &csr) {
+        csr.offsets.assign(nodeNum + 1, 0);
+        int source, target, length;
+        for (int e = 0; e < edgeNum; ++e) {
+            edge(e, source, target, length);
+            ++csr.offsets[source + 1];
+            ++csr.offsets[target + 1];
+        }
+        for (int i = 0; i < nodeNum; ++i) { csr.offsets[i + 1] += csr.offsets[i]; }
+        csr.nodes.resize(csr.offsets.back());
+        csr.lengths.resize(csr.offsets.back());
+        vector<int> next(csr.offsets.begin(), csr.offsets.end() - 1);
+        for (int e = 0; e < edgeNum; ++e) {
+            edge(e, source, target, length);
+            csr.nodes[next[source]] = target;
+            csr.lengths[next[source]++] = length;
+            csr.nodes[next[target]] = source;
+            csr.lengths[next[target]++] = length;
+        }
+    }
+
+    // the max distance from the nodes to their nearest centers (zero-based) by a single Dijkstra from all centers
+    // at once, i.e., O((n + m) log n) instead of O(p n^2). it is INF if some node is unreachable from the centers.
+    static int multiSourceMaxLength(int nodeNum, const int *offsets, const int *nodes, const int *lengths, const vector<int> &centers) {
+        using Entry = pair<long long, int>; // (distance, node).
+        vector<long long> d(nodeNum, INF);
+        priority_queue<Entry, vector<Entry>, greater<Entry>> q;
+        for (auto c = centers.begin(); c != centers.end(); ++c) {
+            if (d[*c] == 0) { continue; }
+            d[*c] = 0;
+            q.push({ 0, *c });
+        }
+        int settledNum = 0;
+        long long maxDist = 0;
+        while (!q.empty()) {
+            Entry top = q.top();
+            q.pop();
+            if (top.first > d[top.second]) { continue; } // outdated.
+            ++settledNum;
+            maxDist = top.first; // the nodes are settled in ascending order of distance.
+            for (int a = offsets[top.second]; a < offsets[top.second + 1]; ++a) {
+                long long dist = top.first + lengths[a];
+                if (dist < d[nodes[a]]) {
+                    d[nodes[a]] = dist;
+                    q.push({ dist, nodes[a] });
                 }
             }
-            if (u == -1) {
-                return d;
-            }
-            vis[u] = true; // uѱ
-            for (int v = 0; v < n; ++v) {
-                if (vis[v] == false && d[u] + G[u][v] < d[v]) {
-                    d[v] = d[u] + G[u][v];
-                    pre[v] = u;
-                }
+        }
+        return ((settledNum < nodeNum) || (maxDist > INF)) ? INF : static_cast<int>(maxDist);
+    }
+
+    // validate the one-based center IDs in [begin, end) with a bitset in O(p + n / 64), and collect them
+    // as zero-based IDs. it returns the ErrorFlag bits, i.e., 0 if they are valid.
+    template<typename IdIterator>
+    static int checkCenters(int nodeNum, int centerNum, IdIterator begin, IdIterator end, vector<int> &centers) {
+        int error = 0;
+        int idNum = 0;
+        vector<bool> isCenter(nodeNum, false);
+        centers.clear();
+        for (; begin != end; ++begin, ++idNum) {
+            int c = *begin - 1;
+            if ((c < 0) || (c >= nodeNum)) {
+                error |= ErrorFlag::FormatError;
+            } else if (isCenter[c]) {
+                error |= ErrorFlag::CenterRepeatedError;
+            } else {
+                isCenter[c] = true;
+                centers.push_back(c);
             }
         }
-        return d;
+        if (idNum != centerNum) { error |= ErrorFlag::FormatError; }
+        return error;
     }
 
-    int generateNum();
-    vector<vector<int>> generateGraph();
-    int generateMaxLength();
+    int generateNum(); // it is -1 if some node ID is not positive.
+    void generateCsr(Csr &csr) const; // O(n + m) memory instead of an n x n matrix.
+    int checkCenters(vector<int> &centers); // call generateNum() first.
+    int generateMaxLength(); // call generateNum() first. it is -1 if the centers are invalid.
 
 
 };
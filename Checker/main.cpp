@@ -2,11 +2,19 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "Visualizer.h"
 
 #include "../Solver/PbReader.h"
 #include "../Solver/PCenter.pb.h"
+#include "../Solver/CsvReader.h"
+#include "../Solver/Utility.h"
 #include "CheckConstraints.h"
 
 
@@ -15,61 +23,230 @@ using namespace szx;
 using namespace pb;
 
 
+namespace {
 
-int main(int argc, char *argv[]) { 
-    enum CheckerFlag {
-        IoError = 0x0,
-        FormatError = 0x1,
-        CenterRepeatedError = 0x2,
+using CheckerFlag = CheckConstraints::ErrorFlag;
+
+// the graph is parsed once and shared by all the solutions on the same instance.
+struct CachedInstance {
+    once_flag loadFlag;
+    bool isLoaded = false;
+    int nodeNum = 0;
+    int centerNum = 0;
+    CheckConstraints::Csr csr;
+};
+
+struct Job {
+    string instPath;
+    string slnPath;
+    int error = -1; // the checker flags, or -1 if the files can not be loaded. it is 0 only if feasible.
+    int obj = -1;
+    double duration = 0; // in milliseconds.
+};
+
+// skip the submission information in the first line.
+bool loadSolution(const string &path, PCenter::Output &output) {
+    ifstream ifs(path);
+    if (!ifs.is_open()) { return false; }
+
+    string line;
+    getline(ifs, line);
+    ostringstream oss;
+    oss << ifs.rdbuf();
+    return jsonToProtobuf(oss.str(), output);
+}
+
+bool loadInstance(const string &path, CachedInstance &inst) {
+    PCenter::Input input;
+    if (!load(path, input)) { return false; }
+    PCenter::Output noOutput;
+    CheckConstraints check(input, noOutput);
+    inst.nodeNum = check.generateNum();
+    if (inst.nodeNum <= 0) { return false; }
+    inst.centerNum = input.centernum();
+    check.generateCsr(inst.csr); // only the graph is kept.
+    return true;
+}
+
+// return the error flags and compute the objective if there is no error.
+int check(const CachedInstance &inst, const PCenter::Output &output, int &obj) {
+    vector<int> centers;
+    int error = CheckConstraints::checkCenters(inst.nodeNum, inst.centerNum, output.centers().begin(), output.centers().end(), centers);
+    if (error == 0) {
+        obj = CheckConstraints::multiSourceMaxLength(inst.nodeNum,
+            inst.csr.offsets.data(), inst.csr.nodes.data(), inst.csr.lengths.data(), centers);
+    }
+    return error;
+}
+
+bool endsWith(const string &str, const string &suffix) {
+    return (str.size() >= suffix.size()) && (str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+// quote the string for JSON.
+string jsonString(const string &str) {
+    string quoted("\"");
+    for (auto c = str.begin(); c != str.end(); ++c) {
+        if ((*c == '"') || (*c == '\\')) { quoted += '\\'; }
+        quoted += *c;
+    }
+    return quoted + '"';
+}
+
+// collect the jobs from the "instance;solution" lines of the manifest, or from the solutions in the directory
+// whose instances are named in their submission information. the other files in the directory are skipped.
+bool collectJobs(const string &batchPath, const string &instDir, vector<Job> &jobs) {
+    vector<string> slnPaths;
+    if (System::listFiles(batchPath, slnPaths)) {
+        for (auto p = slnPaths.begin(); p != slnPaths.end(); ++p) {
+            if (!endsWith(*p, ".json")) { continue; } // e.g., the ones being written end with ".tmp".
+            PCenter::Submission submission;
+            ifstream ifs(*p);
+            string line;
+            getline(ifs, line);
+            if (!jsonToProtobuf(line, submission) || submission.instance().empty()) { continue; }
+            Job job;
+            job.instPath = instDir + submission.instance();
+            job.slnPath = *p;
+            jobs.push_back(job);
+        }
+        return true;
+    }
+
+    ifstream ifs(batchPath);
+    if (!ifs.is_open()) { return false; }
+    CsvReader cr;
+    const vector<CsvReader::Row> &rows(cr.scan(ifs));
+    for (auto row = rows.begin(); row != rows.end(); ++row) {
+        if (((*row)[0][0] == '#') || (row->size() < 2)) { continue; } // comment or incomplete.
+        Job job;
+        job.instPath = (*row)[0];
+        job.slnPath = (*row)[1];
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+bool writeReport(const string &path, const vector<Job> &jobs) {
+    ofstream ofs(path);
+    if (!ofs.is_open()) { return false; }
+    bool isJson = endsWith(path, ".json");
+    ofs << (isJson ? "[" : "Instance,Solution,Feasible,Obj,Error,Milliseconds") << endl;
+    for (auto job = jobs.begin(); job != jobs.end(); ++job) {
+        if (isJson) {
+            ofs << ((job == jobs.begin()) ? "  " : ", ") << "{\"instance\":" << jsonString(job->instPath)
+                << ",\"solution\":" << jsonString(job->slnPath) << ",\"feasible\":" << ((job->error == 0) ? "true" : "false")
+                << ",\"obj\":" << job->obj << ",\"error\":" << job->error
+                << ",\"milliseconds\":" << job->duration << "}" << endl;
+        } else {
+            ofs << job->instPath << "," << job->slnPath << "," << (job->error == 0) << "," << job->obj << ","
+                << job->error << "," << job->duration << endl;
+        }
+    }
+    if (isJson) { ofs << "]" << endl; }
+    return static_cast<bool>(ofs);
+}
+
+// check the solutions with threadNum threads. it returns the number of infeasible ones, or -1 on IO error.
+int runBatch(const string &batchPath, const string &instDir, const string &reportPath, int threadNum) {
+    vector<Job> jobs;
+    if (!collectJobs(batchPath, instDir, jobs)) {
+        cerr << "fail to open " << batchPath << endl;
+        return -1;
+    }
+
+    map<string, shared_ptr<CachedInstance>> instances;
+    for (auto job = jobs.begin(); job != jobs.end(); ++job) {
+        shared_ptr<CachedInstance> &inst(instances[job->instPath]);
+        if (!inst) { inst = make_shared<CachedInstance>(); }
+    }
+
+    atomic<int> nextJob(0);
+    auto work = [&]() {
+        for (int j; (j = nextJob.fetch_add(1)) < static_cast<int>(jobs.size());) {
+            Job &job(jobs[j]);
+            auto begin = chrono::steady_clock::now();
+            CachedInstance &inst(*instances.at(job.instPath)); // read only after the construction.
+            call_once(inst.loadFlag, [&]() { inst.isLoaded = !job.instPath.empty() && loadInstance(job.instPath, inst); });
+            PCenter::Output output;
+            if (inst.isLoaded && loadSolution(job.slnPath, output)) { job.error = check(inst, output, job.obj); }
+            job.duration = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        }
     };
+    threadNum = max(1, min(threadNum, static_cast<int>(jobs.size())));
+    vector<thread> threadList;
+    threadList.reserve(threadNum);
+    for (int i = 0; i < threadNum; ++i) { threadList.emplace_back(work); }
+    for (auto t = threadList.begin(); t != threadList.end(); ++t) { t->join(); }
 
+    if (!writeReport(reportPath, jobs)) {
+        cerr << "fail to write " << reportPath << endl;
+        return -1;
+    }
+    int infeasibleNum = 0;
+    for (auto job = jobs.begin(); job != jobs.end(); ++job) { infeasibleNum += (job->error != 0); }
+    cout << "checked " << jobs.size() << " solutions, " << infeasibleNum << " infeasible." << endl;
+    return infeasibleNum;
+}
+
+}
+
+
+int main(int argc, char *argv[]) {
     /*string inputPath = "C:\\Users\\jinqi\\Desktop\\NPBenchmark-PCenter-master\\Deploy\\Instance\\pmed1.json";
     string outputPath = "C:\\Users\\jinqi\\Desktop\\NPBenchmark-PCenter-master\\Deploy\\Solution\\pmed1.json";*/
 
-    string inputPath;
-    string outputPath;
+    string batchPath;
+    string instDir = "Instance/";
+    string reportPath = "check.csv";
+    int threadNum = thread::hardware_concurrency();
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        if ((i + 1 < argc) && (arg == "-batch")) {
+            batchPath = argv[++i];
+        } else if ((i + 1 < argc) && (arg == "-instances")) {
+            instDir = argv[++i];
+            if ((instDir.back() != '/') && (instDir.back() != '\\')) { instDir += '/'; }
+        } else if ((i + 1 < argc) && (arg == "-report")) {
+            reportPath = argv[++i];
+        } else if ((i + 1 < argc) && (arg == "-j")) {
+            threadNum = atoi(argv[++i]);
+        } else {
+            args.push_back(arg);
+        }
+    }
 
-    if (argc > 1) {
-        inputPath = argv[1];
-    } else {
-        cerr << "input path: " << flush;
-        cin >> inputPath;
+    if (!batchPath.empty()) {
+        int infeasibleNum = runBatch(batchPath, instDir, reportPath, threadNum);
+        return (infeasibleNum == 0) ? 0 : 1;
     }
 
-    if (argc > 2) {
-        outputPath = argv[2];
-    } else {
-        cerr << "output path: " << flush;
-        cin >> outputPath;
+    if (args.size() < 2) {
+        cerr << "usage: Checker instance solution\n"
+            << "       Checker -batch (dir|manifest) [-instances dir] [-report path.csv|path.json] [-j int]\n"
+            << "the manifest lines are \"instance;solution\". in a solution directory, the instances are found\n"
+            << "in the instance directory (Instance/ by default) by the names in the submission information." << endl;
+        return ~CheckerFlag::IoError;
     }
+    string inputPath = args[0];
+    string outputPath = args[1];
 
     pb::PCenter::Input input;
     if (!load(inputPath, input)) { return ~CheckerFlag::IoError; }
 
     pb::PCenter::Output output;
-    ifstream ifs(outputPath);
-    if (!ifs.is_open()) { return ~CheckerFlag::IoError; }
-
-    string submission;
-    getline(ifs, submission); // skip the first line.
-    ostringstream oss;
-    oss << ifs.rdbuf();
-    jsonToProtobuf(oss.str(), output);
+    if (!loadSolution(outputPath, output)) { return ~CheckerFlag::IoError; }
 
     // check solution.
-    int error = 0;
-    int maxLength = 0;
-    if (output.centers().size() != input.centernum()) { error |= CheckerFlag::FormatError; }
-    for (int i = 0; i < output.centers().size(); ++i) {
-        for (int j = i + 1; j < output.centers().size(); ++j) {
-            if (output.centers(i) == output.centers(j))
-                error |= CheckerFlag::CenterRepeatedError;
-        }
-    }
     CheckConstraints check(input, output);
-    check.generateNum();
-    maxLength = check.generateMaxLength();
-    int returnCode = (error == 0) ? maxLength: ~error;
+    if (check.generateNum() <= 0) { return ~CheckerFlag::FormatError; }
+    vector<int> centers;
+    int error = check.checkCenters(centers);
+    int maxLength = (error == 0) ? check.generateMaxLength() : -1;
+    // the exit code is truncated on most platforms, so the objective is printed as well.
+    cout << "obj: " << maxLength << endl;
+    int returnCode = (error == 0) ? 0 : ~error;
     cout << "returnCoded: " << returnCode << endl;
     return returnCode;
 }
@@ -0,0 +1,151 @@
+#include "PCenterApi.h"
+
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include "../Solver/Solver.h"
+#include "../Solver/Problem.h"
+
+
+using namespace std;
+using namespace szx;
+
+
+struct PCenterContext {
+    Problem::Input input; // read only after it is created.
+    shared_ptr<const Solver::DistanceTable> table; // built by the first solve.
+
+    // the settings and results below are guarded by it, since they are accessed by other threads during a solve.
+    // it is only held for copying them, so the accessors do not wait for the running solve.
+    mutable mutex stateMutex;
+    int centerNum = 1;
+    double timeout = Solver::Environment::DefaultTimeout;
+    int randSeed = Random::generateSeed();
+    int threadNum = 1;
+
+    mutex solveMutex; // serialize the solves on the same context.
+    CancellationToken cancellation; // the parent of the token of the running solver.
+
+    Length objective = -1;
+    List<ID> centers; // zero-based node IDs.
+};
+
+
+PCenterContext* pcenter_create(int nodeNum, int edgeNum, const int *edges) {
+    if ((nodeNum <= 0) || (edgeNum < 0) || (!edges && (edgeNum > 0))) { return nullptr; }
+    PCenterContext *context = new (nothrow) PCenterContext();
+    if (!context) { return nullptr; }
+    try {
+        context->input.nodeNum = nodeNum;
+        List<Problem::Edge> &edgeList(context->input.edgeList);
+        edgeList.resize(edgeNum);
+        for (int e = 0; e < edgeNum; ++e, edges += 3) {
+            if ((edges[0] < 0) || (edges[0] >= nodeNum) || (edges[1] < 0) || (edges[1] >= nodeNum) || (edges[2] < 0)) {
+                delete context;
+                return nullptr;
+            }
+            edgeList[e] = { edges[0], edges[1], edges[2] };
+        }
+    } catch (...) {
+        delete context;
+        return nullptr;
+    }
+    return context;
+}
+
+void pcenter_destroy(PCenterContext *context) {
+    delete context;
+}
+
+PCenterStatus pcenter_set_center_num(PCenterContext *context, int centerNum) {
+    if (!context || (centerNum <= 0) || (centerNum > context->input.nodeNum)) { return PCENTER_INVALID_ARGUMENT; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    context->centerNum = centerNum;
+    return PCENTER_OK;
+}
+
+PCenterStatus pcenter_set_timeout(PCenterContext *context, double timeoutInSecond) {
+    if (!context || !(timeoutInSecond >= 0)) { return PCENTER_INVALID_ARGUMENT; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    context->timeout = timeoutInSecond;
+    return PCENTER_OK;
+}
+
+PCenterStatus pcenter_set_seed(PCenterContext *context, int randSeed) {
+    if (!context) { return PCENTER_INVALID_ARGUMENT; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    context->randSeed = randSeed;
+    return PCENTER_OK;
+}
+
+PCenterStatus pcenter_set_thread_num(PCenterContext *context, int threadNum) {
+    if (!context || (threadNum <= 0)) { return PCENTER_INVALID_ARGUMENT; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    context->threadNum = threadNum;
+    return PCENTER_OK;
+}
+
+PCenterStatus pcenter_solve(PCenterContext *context, PCenterProgressCallback onProgress, void *userData) {
+    if (!context) { return PCENTER_INVALID_ARGUMENT; }
+    PCenterStatus status = PCENTER_OK;
+    unique_lock<mutex> solveLock(context->solveMutex, defer_lock); // the cancellation is reset under it.
+    try {
+        solveLock.lock();
+        context->cancellation.reset(); // drop the cancellations before this solve.
+        Solver::Environment env;
+        {
+            lock_guard<mutex> stateGuard(context->stateMutex);
+            context->objective = -1;
+            context->centers.clear();
+            // no solution or log file is written since the paths are empty.
+            env = Solver::Environment("", "", context->randSeed, context->timeout,
+                Solver::Environment::DefaultMaxIter, context->threadNum, "", "", "");
+            env.centerNum = context->centerNum;
+        }
+        env.calibrate();
+        Solver::Configuration cfg;
+        if (!context->table) {
+            shared_ptr<Solver::DistanceTable> table(make_shared<Solver::DistanceTable>());
+            Solver::buildDistanceTable(context->input, cfg, env.jobNum, *table);
+            context->table = table;
+        }
+
+        Solver solver(context->input, env, cfg);
+        solver.aux.table = context->table;
+        solver.cancellation.link(&context->cancellation);
+        if (onProgress) { solver.progress.redirect([&](const String &line) { onProgress(line.c_str(), userData); }); }
+        if (solver.solve()) {
+            List<ID> centers(solver.output.centers_size());
+            for (int i = 0; i < solver.output.centers_size(); ++i) { centers[i] = solver.output.centers(i) - 1; }
+            lock_guard<mutex> stateGuard(context->stateMutex);
+            context->objective = solver.output.maxLength;
+            context->centers.swap(centers);
+        } else {
+            status = PCENTER_NO_SOLUTION;
+        }
+    } catch (const bad_alloc&) {
+        status = PCENTER_OUT_OF_MEMORY;
+    } catch (...) {
+        status = PCENTER_INTERNAL_ERROR;
+    }
+    return status;
+}
+
+void pcenter_cancel(PCenterContext *context) {
+    if (context) { context->cancellation.cancel(); }
+}
+
+int pcenter_objective(const PCenterContext *context) {
+    if (!context) { return -1; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    return context->objective;
+}
+
+int pcenter_centers(const PCenterContext *context, int *centers, int capacity) {
+    if (!context) { return 0; }
+    lock_guard<mutex> stateGuard(context->stateMutex);
+    int centerNum = static_cast<int>(context->centers.size());
+    for (int i = 0; (i < centerNum) && (i < capacity); ++i) { centers[i] = context->centers[i]; }
+    return centerNum;
+}
@@ -0,0 +1,74 @@
+////////////////////////////////
+/// usage : 1.	C interface of the solver for embedding it in other processes, i.e., build the instance from
+///             the edges in memory, solve it and read the centers without touching the file system.
+///
+/// note  : 1.	the node IDs are zero-based, and the graph is undirected.
+///         2.	the distance table is built by the first solve and kept in the context, so the following
+///             solves on the same context with different settings skip it.
+///         3.	a context solves one request at a time, while the contexts are independent of each other.
+///         4.	no exception crosses the interface. the functions report errors by PCenterStatus.
+////////////////////////////////
+
+#ifndef SMART_JQ_PCENTER_API_H
+#define SMART_JQ_PCENTER_API_H
+
+
+#if defined(_WIN32)
+#ifdef PCENTER_EXPORTS
+#define PCENTER_API  __declspec(dllexport)
+#else
+#define PCENTER_API  __declspec(dllimport)
+#endif // PCENTER_EXPORTS
+#else
+#define PCENTER_API  __attribute__((visibility("default")))
+#endif // _WIN32
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct PCenterContext PCenterContext;
+
+typedef enum PCenterStatus {
+    PCENTER_OK = 0,
+    PCENTER_INVALID_ARGUMENT = -1,
+    PCENTER_NO_SOLUTION = -2,
+    PCENTER_OUT_OF_MEMORY = -3,
+    PCENTER_INTERNAL_ERROR = -4 // any other failure inside the solver, e.g., the threads can not be created.
+} PCenterStatus;
+
+// it is called with each event of the progress stream as a JSON line without line ending, i.e., the improvements,
+// the heartbeats and the final one. it is called by a background thread, one event at a time.
+typedef void (*PCenterProgressCallback)(const char *event, void *userData);
+
+
+// copy the graph of nodeNum nodes and edgeNum edges, where edges[3 * e .. 3 * e + 2] is the source, target
+// and length of edge e. it returns null if the graph is invalid.
+PCENTER_API PCenterContext* pcenter_create(int nodeNum, int edgeNum, const int *edges);
+PCENTER_API void pcenter_destroy(PCenterContext *context);
+
+// the settings take effect from the next solve. the time limit is in seconds, which is 60 by default.
+// the settings and the results below can be accessed by any thread, including during a solve.
+PCENTER_API PCenterStatus pcenter_set_center_num(PCenterContext *context, int centerNum);
+PCENTER_API PCenterStatus pcenter_set_timeout(PCenterContext *context, double timeoutInSecond);
+PCENTER_API PCenterStatus pcenter_set_seed(PCenterContext *context, int randSeed);
+PCENTER_API PCenterStatus pcenter_set_thread_num(PCenterContext *context, int threadNum);
+
+// block until the time is up or it is cancelled. the progress callback can be null.
+PCENTER_API PCenterStatus pcenter_solve(PCenterContext *context, PCenterProgressCallback onProgress, void *userData);
+// make the running solve return with its best solution as soon as possible. it can be called by any thread.
+// it is dropped if no solve is running, i.e., each solve starts without cancellation.
+PCENTER_API void pcenter_cancel(PCenterContext *context);
+
+// the radius of the last solution, or -1 if there is none.
+PCENTER_API int pcenter_objective(const PCenterContext *context);
+// copy at most capacity centers of the last solution and return the number of centers in it.
+PCENTER_API int pcenter_centers(const PCenterContext *context, int *centers, int capacity);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+
+#endif // SMART_JQ_PCENTER_API_H
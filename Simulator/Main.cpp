@@ -12,7 +12,10 @@ int main() {
     sim.debug();
     //sim.benchmark(1);
     //sim.parallelBenchmark(1);
+    //sim.batchBenchmark(1);
     //sim.generateInstance();
+    //sim.convertInstances();
+    //sim.generateScalingSuite();
 
     return 0;
 }
\ No newline at end of file
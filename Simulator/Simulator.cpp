@@ -6,7 +6,11 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <chrono>
+#include <memory>
+#include <mutex>
 
+#include <cmath>
 #include <cstring>
 
 #include "Simulator.h"
@@ -20,6 +24,110 @@ using namespace std;
 
 namespace szx {
 
+namespace {
+
+// the distributions are implemented here so that the instances are the same on all platforms.
+double uniform(Random &r) { return (r.rgen() >> 11) * (1.0 / 9007199254740992.0); } // in [0, 1).
+double gaussian(Random &r) { // Box-Muller transform.
+    constexpr double Pi = 3.14159265358979323846;
+    double radius = sqrt(-2.0 * log(1.0 - uniform(r)));
+    return radius * cos(2.0 * Pi * uniform(r));
+}
+
+class DisjointSet {
+public:
+    DisjointSet(ID nodeNum) : parent(nodeNum) {
+        for (ID n = 0; n < nodeNum; ++n) { parent[n] = n; }
+    }
+
+    ID find(ID n) {
+        for (; parent[n] != n; n = parent[n]) { parent[n] = parent[parent[n]]; }
+        return n;
+    }
+    // return false if they are already in the same set.
+    bool unite(ID l, ID r) {
+        l = find(l);
+        r = find(r);
+        if (l == r) { return false; }
+        parent[(max)(l, r)] = (min)(l, r);
+        return true;
+    }
+
+protected:
+    List<ID> parent;
+};
+
+// connect the nodes by the lattice or the nearest neighbors, and then make sure the graph is connected.
+void buildGraph(const Simulator::SyntheticSetting &setting, Random &r, Problem::Input &input) {
+    using Family = Simulator::SyntheticSetting::Family;
+
+    ID nodeNum = input.nodeNum;
+    List<pair<ID, ID>> links;
+    if (setting.family == Family::Grid) {
+        // keep the lattice edges to reach the degree, then add the diagonal shortcuts.
+        double degree = (setting.degree > 0) ? setting.degree : 4;
+        double keepRate = (min)(1.0, degree / 4);
+        double diagonalRate = (max)(0.0, (min)(1.0, (degree - 4) / 4));
+        ID colNum = static_cast<ID>(ceil(sqrt(nodeNum)));
+        for (ID n = 0; n < nodeNum; ++n) {
+            ID col = n % colNum;
+            if ((col + 1 < colNum) && (n + 1 < nodeNum) && (uniform(r) < keepRate)) { links.push_back({ n, n + 1 }); }
+            if ((n + colNum < nodeNum) && (uniform(r) < keepRate)) { links.push_back({ n, n + colNum }); }
+            if ((col + 1 < colNum) && (n + colNum + 1 < nodeNum) && (uniform(r) < diagonalRate)) { links.push_back({ n, n + colNum + 1 }); }
+            if ((col > 0) && (n + colNum - 1 < nodeNum) && (uniform(r) < diagonalRate)) { links.push_back({ n, n + colNum - 1 }); }
+        }
+    } else {
+        // each node links to its ceil(degree / 2) nearest neighbors.
+        int k = (max)(1, static_cast<int>(ceil(setting.degree / 2)));
+        DistanceOracle oracle;
+        oracle.init(input);
+        SpatialGrid grid;
+        grid.init(oracle);
+        List<ID> nearest;
+        for (ID u = 0; u < nodeNum; ++u) {
+            grid.nearest(u, k + 1, nearest);
+            for (auto v = nearest.begin(); v != nearest.end(); ++v) {
+                if (*v != u) { links.push_back({ (min)(u, *v), (max)(u, *v) }); }
+            }
+        }
+        sort(links.begin(), links.end());
+        links.erase(unique(links.begin(), links.end()), links.end());
+    }
+
+    // chain the components along the x axis.
+    DisjointSet components(nodeNum);
+    for (auto l = links.begin(); l != links.end(); ++l) { components.unite(l->first, l->second); }
+    List<ID> nodes(nodeNum);
+    for (ID n = 0; n < nodeNum; ++n) { nodes[n] = n; }
+    sort(nodes.begin(), nodes.end(), [&](ID l, ID r) {
+        return (input.xCoords[l] != input.xCoords[r]) ? (input.xCoords[l] < input.xCoords[r]) : (l < r);
+    });
+    for (ID n = 1; n < nodeNum; ++n) {
+        if (components.unite(nodes[n - 1], nodes[n])) { links.push_back({ nodes[n - 1], nodes[n] }); }
+    }
+
+    input.edgeList.clear();
+    input.edgeList.reserve(links.size());
+    for (auto l = links.begin(); l != links.end(); ++l) {
+        double dx = input.xCoords[l->first] - input.xCoords[l->second];
+        double dy = input.yCoords[l->first] - input.yCoords[l->second];
+        Length length = (max)(1, static_cast<Length>(sqrt(dx * dx + dy * dy) + 0.5));
+        input.edgeList.push_back({ l->first, l->second, length });
+    }
+}
+
+}
+
+String Simulator::SyntheticSetting::name() const {
+    static const String familyNames[] = { "geo", "grid", "cluster" };
+    ostringstream oss;
+    oss << familyNames[family] << "-n" << nodeNum << "-p" << centerNum;
+    if ((degree > 0) || (family == Family::Grid)) { oss << "-d" << ((degree > 0) ? degree : 4); }
+    if (family == Family::Clustered) { oss << "-c" << clusterNum; }
+    oss << "-s" << seed;
+    return oss.str();
+}
+
 void Simulator::initDefaultEnvironment() {
     Solver::Environment env;
     env.save(Env::DefaultEnvPath());
@@ -143,61 +251,261 @@ void Simulator::benchmark(int repeat) {
     }
 }
 
-void Simulator::parallelBenchmark(int repeat) { //ڵ⣺1
-
-    Task task;
-    task.instSet = "";
-    //task.timeout = "180";
-    //task.maxIter = "1000000000";
-    task.timeout = "3600";
-    //task.maxIter = "1000000000";
-    task.jobNum = "1";
-    task.cfgPath = Env::DefaultCfgPath();
-    task.logPath = Env::DefaultLogPath();
-
-    ThreadPool<> tp(4);
+void Simulator::parallelBenchmark(int repeat, int threadNumPerJob, const String &reportPath) {
+    struct Instance {
+        String name;
+        once_flag tableFlag;
+        Problem::Input input;
+        shared_ptr<const Solver::DistanceTable> table; // shared by the repeated runs.
+    };
+    struct Result {
+        Length obj;
+        double duration; // in seconds.
+        System::MemoryUsage peakMemory; // of the whole process when the job ends.
+    };
+    struct Job {
+        shared_ptr<Instance> instance;
+        Env env;
+        long long cost; // estimated by n * p.
+        future<Result> result;
+    };
+
+    threadNumPerJob = (max)(threadNumPerJob, 1);
+    int slotNum = (max)(static_cast<int>(thread::hardware_concurrency()) / threadNumPerJob, 1);
+    Solver::Configuration cfg;
+    cfg.load(Env::DefaultCfgPath());
+    System::makeSureDirExist(SolutionDir());
 
-    random_device rd;
-    mt19937 rgen(rd());
     // EXTEND[szx][5]: read it from InstanceList.txt.
-    vector<String> instList({ "pmed1", "pmed2", "pmed3", "pmed4", "pmed5", "pmed6", "pmed7", "pmed8", "pmed9", "pmed10",
-        "pmed11", "pmed12", "pmed13", "pmed14", "pmed15", "pmed16", "pmed17", "pmed18", "pmed19", "pmed20",
-        "pmed21", "pmed22", "pmed23", "pmed24", "pmed25", "pmed26", "pmed27", "pmed28", "pmed29", "pmed30",
-        "pmed31", "pmed32", "pmed33", "pmed34", "pmed35", "pmed36", "pmed37", "pmed38", "pmed39", "pmed40", });
+    List<Job> jobs;
+    for (int inst = 1; inst <= 40; ++inst) {
+        shared_ptr<Instance> instance(make_shared<Instance>());
+        instance->name = "pmed" + to_string(inst);
+        if (!instance->input.load(InstanceDir() + instance->name + FileExtension::json())) {
+            cerr << "fail to load " << instance->name << endl;
+            continue;
+        }
+        for (int i = 0; i < repeat; ++i) { // each run writes its own solution.
+            Env env(InstanceDir() + instance->name + FileExtension::json(),
+                SolutionDir() + instance->name + "." + to_string(i) + FileExtension::json(),
+                Random::generateSeed(), 3600, Env::DefaultMaxIter, threadNumPerJob, to_string(i));
+            env.calibrate();
+            jobs.push_back({ instance, env, static_cast<long long>(instance->input.nodeNum) * instance->input.centernum(), future<Result>() });
+        }
+    }
+    // longest processing time first.
+    stable_sort(jobs.begin(), jobs.end(), [](const Job &l, const Job &r) { return l.cost > r.cost; });
+
+    Timer::TimePoint begin = Timer::Clock::now();
+    {
+        ThreadPool<impl::ThreadPool::WorkStealingImpl> tp(slotNum);
+        for (auto job = jobs.begin(); job != jobs.end(); ++job) {
+            shared_ptr<Instance> instance(job->instance);
+            Env env(job->env);
+            job->result = tp.submit([instance, env, &cfg]() {
+                call_once(instance->tableFlag, [&]() {
+                    shared_ptr<Solver::DistanceTable> table(make_shared<Solver::DistanceTable>());
+                    Solver::buildDistanceTable(instance->input, cfg, env.jobNum, *table);
+                    instance->table = table;
+                });
+                Timer::TimePoint jobBegin = Timer::Clock::now();
+                Result r;
+                r.obj = Cmd::solve(instance->input, env, cfg, instance->table);
+                r.duration = chrono::duration<double>(Timer::Clock::now() - jobBegin).count();
+                r.peakMemory = System::peakMemoryUsage();
+                return r;
+            });
+        }
+    }
+    double makespan = chrono::duration<double>(Timer::Clock::now() - begin).count();
+
+    ofstream report(reportPath);
+    report << "Instance,Run,Seed,NodeNum,CenterNum,Threads,Obj,Duration,PhysMem,VirtMem" << endl;
+    int failedNum = 0;
+    for (auto job = jobs.begin(); job != jobs.end(); ++job) {
+        Result r = { -1, 0, { 0, 0 } };
+        try {
+            r = job->result.get();
+        } catch (const exception &e) {
+            cerr << "job " << job->env.rid << " on " << job->instance->name << " failed: " << e.what() << endl;
+        }
+        if (r.obj < 0) { ++failedNum; }
+        report << job->instance->name << "," << job->env.rid << "," << job->env.randSeed << ","
+            << job->instance->input.nodeNum << "," << job->instance->input.centernum() << "," << threadNumPerJob << ","
+            << r.obj << "," << r.duration << "," << r.peakMemory.physicalMemory << "," << r.peakMemory.virtualMemory << endl;
+    }
+    cout << "solved " << jobs.size() << " jobs in " << makespan << "s with " << slotNum << " slots, "
+        << failedNum << " failed." << endl;
+}
+
+void Simulator::batchBenchmark(int repeat, int threadNum) {
+    String manifestPath("manifest.csv");
+    ofstream manifest(manifestPath);
+    System::makeSureDirExist(SolutionDir());
     for (int i = 0; i < repeat; ++i) {
-        //shuffle(instList.begin(), instList.end(), rgen);
-        for (auto inst = instList.begin(); inst != instList.end(); ++inst) {
-            task.instId = *inst;
-            task.randSeed = to_string(Random::generateSeed());
-            task.runId = to_string(i);
-            tp.push([=]() { run(task); });
-            this_thread::sleep_for(1s);
+        for (int inst = 1; inst <= 40; ++inst) {
+            String instName("pmed" + to_string(inst));
+            manifest << InstanceDir() << instName << FileExtension::json() << ";" << Random::generateSeed() << ";3600;"
+                << SolutionDir() << instName << "." << i << FileExtension::json() << endl;
+        }
+    }
+    manifest.close();
+
+    char argBuf[Cmd::MaxArgNum][Cmd::MaxArgLen];
+    char *argv[Cmd::MaxArgNum];
+    for (int i = 0; i < Cmd::MaxArgNum; ++i) { argv[i] = argBuf[i]; }
+    strcpy(argv[ArgIndex::ExeName], ProgramName().c_str());
+
+    int argc = ArgIndex::ArgStart;
+
+    strcpy(argv[argc++], Cmd::BatchPathOption().c_str());
+    strcpy(argv[argc++], manifestPath.c_str());
+
+    strcpy(argv[argc++], Cmd::SummaryPathOption().c_str());
+    strcpy(argv[argc++], Env::DefaultSummaryPath().c_str());
+
+    if (threadNum > 0) {
+        strcpy(argv[argc++], Cmd::JobNumOption().c_str());
+        strcpy(argv[argc++], to_string(threadNum).c_str());
+    }
+
+    Cmd::run(argc, argv);
+}
+
+bool Simulator::convertInstance(const String &instName, bool withDistMatrix) {
+    Problem::Input input;
+    if (!input.load(InstanceDir() + instName + FileExtension::json())) { return false; }
+
+    String binPath(InstanceDir() + instName + FileExtension::binary());
+    if (!withDistMatrix) { return InstanceReader::saveBinary(binPath, input); }
+
+    List<List<Length>> dist;
+    Solver::shortestPaths(input, dist);
+    return InstanceReader::saveBinary(binPath, input, &dist);
+}
+
+void Simulator::convertInstances(bool withDistMatrix) {
+    for (int i = 1; i <= 40; ++i) {
+        String instName("pmed" + to_string(i));
+        if (!convertInstance(instName, withDistMatrix)) { cerr << "fail to convert " << instName << endl; }
+    }
+}
+
+bool Simulator::generateInstance(const SyntheticSetting &setting) {
+    constexpr double AverageSpacing = 100; // keep the same density of nodes for all sizes.
+
+    InstanceTrait trait;
+    if ((setting.nodeNum < trait.pointNum.begin) || (setting.nodeNum > trait.pointNum.end)) { return false; }
+    if ((setting.centerNum < trait.centerNum.begin) || (setting.centerNum > trait.centerNum.end)) { return false; }
+    if ((setting.centerNum >= setting.nodeNum) || (setting.clusterNum <= 0)) { return false; }
+
+    Random r(setting.seed);
+    Problem::Input input;
+    input.nodeNum = setting.nodeNum;
+    input.set_centernum(setting.centerNum);
+    input.metric = Problem::Metric::Euc2d;
+    List<double> &x(input.xCoords);
+    List<double> &y(input.yCoords);
+    x.resize(setting.nodeNum);
+    y.resize(setting.nodeNum);
+    double side = AverageSpacing * sqrt(setting.nodeNum);
+    if (setting.family == SyntheticSetting::Family::Geometric) {
+        for (ID n = 0; n < setting.nodeNum; ++n) {
+            x[n] = uniform(r) * side;
+            y[n] = uniform(r) * side;
+        }
+    } else if (setting.family == SyntheticSetting::Family::Clustered) {
+        List<double> cx(setting.clusterNum);
+        List<double> cy(setting.clusterNum);
+        for (int c = 0; c < setting.clusterNum; ++c) {
+            cx[c] = uniform(r) * side;
+            cy[c] = uniform(r) * side;
+        }
+        double sigma = side / (4 * sqrt(setting.clusterNum));
+        for (ID n = 0; n < setting.nodeNum; ++n) {
+            int c = r.pick(setting.clusterNum);
+            x[n] = cx[c] + gaussian(r) * sigma;
+            y[n] = cy[c] + gaussian(r) * sigma;
+        }
+    } else { // jittered lattice.
+        ID colNum = static_cast<ID>(ceil(sqrt(setting.nodeNum)));
+        for (ID n = 0; n < setting.nodeNum; ++n) {
+            x[n] = ((n % colNum) + (uniform(r) - 0.5) / 2) * AverageSpacing;
+            y[n] = ((n / colNum) + (uniform(r) - 0.5) / 2) * AverageSpacing;
         }
     }
+
+    String path(InstanceDir() + setting.name());
+    if ((setting.degree <= 0) && (setting.family != SyntheticSetting::Family::Grid)) {
+        return InstanceReader::saveTsplib(path + FileExtension::tsplib(), input, setting.name())
+            && InstanceReader::saveBinary(path + FileExtension::binary(), input);
+    }
+
+    buildGraph(setting, r, input);
+    input.metric = Problem::Metric::Explicit;
+    input.xCoords.clear();
+    input.yCoords.clear();
+    return InstanceReader::saveJson(path + FileExtension::json(), input)
+        && InstanceReader::saveBinary(path + FileExtension::binary(), input);
+}
+
+void Simulator::generateInstances(const List<SyntheticSetting> &settings, int threadNum) {
+    if (threadNum <= 0) { threadNum = thread::hardware_concurrency(); }
+    System::makeSureDirExist(InstanceDir());
+
+    // the largest ones go first to balance the load.
+    List<SyntheticSetting> sortedSettings(settings);
+    stable_sort(sortedSettings.begin(), sortedSettings.end(), [](const SyntheticSetting &l, const SyntheticSetting &r) {
+        return l.nodeNum > r.nodeNum;
+    });
+
+    ThreadPool<> tp(threadNum);
+    for (auto s = sortedSettings.begin(); s != sortedSettings.end(); ++s) {
+        SyntheticSetting setting(*s);
+        tp.push([=]() {
+            if (!generateInstance(setting)) { cerr << "fail to generate " << setting.name() << endl; }
+        });
+    }
+}
+
+void Simulator::generateScalingSuite(int seed) {
+    List<SyntheticSetting> settings;
+    SyntheticSetting setting;
+    setting.seed = seed;
+    for (int nodeNum : { 1000, 3000, 10000, 30000, 100000 }) {
+        setting.nodeNum = nodeNum;
+        setting.centerNum = nodeNum / 100;
+        setting.degree = 0;
+        setting.family = SyntheticSetting::Family::Geometric;
+        settings.push_back(setting);
+        setting.family = SyntheticSetting::Family::Clustered;
+        settings.push_back(setting);
+    }
+    // the solver computes all-pairs shortest paths on the graphs, so they are smaller.
+    for (int nodeNum : { 1000, 2000, 3000 }) {
+        setting.nodeNum = nodeNum;
+        setting.centerNum = nodeNum / 100;
+        setting.family = SyntheticSetting::Family::Geometric;
+        setting.degree = 8;
+        settings.push_back(setting);
+        setting.family = SyntheticSetting::Family::Grid;
+        setting.degree = 4;
+        settings.push_back(setting);
+    }
+    generateInstances(settings);
 }
 
 void Simulator::generateInstance(const string location, const int num) {
     Problem::Input input;
-    string str;
-    int line;
-    vector<int> vec;
-    //location = "D:\\vs-c\\IOstream\\instance\\pmed1.txt";
-    ifstream infile(location);
-    if (!infile.is_open()) { 
+    if (!InstanceReader::loadOrLibrary(location, input)) {
         cerr << "can not open file!";
         return;
     }
-    getline(infile, str);
-    vec = SplitString_s(str, " ");
-    input.set_centernum(vec[2]);
-    line = vec[1];
-    while (!infile.eof()) {
-        getline(infile, str);
-        vec = SplitString_s(str, " ");
+    for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
         auto &edge(*input.mutable_graph()->add_edges());
-        edge.set_source(vec[0]);
-        edge.set_target(vec[1]);
-        edge.set_length(vec[2]);
+        edge.set_source(e->source + 1);
+        edge.set_target(e->target + 1);
+        edge.set_length(e->length);
     }
     ostringstream path;
     path << InstanceDir() << "pmed"<< num << ".json";
@@ -205,20 +513,6 @@ void Simulator::generateInstance(const string location, const int num) {
     //cout << "done" << endl;
 }
 
-vector<int> Simulator::SplitString_s(const string& str, const char* separator) {
-    vector<int> vec;
-    char *input = (char *)str.c_str();
-    char *next_token = nullptr;
-    char *p = strtok_s(input, separator, &next_token);
-    int a;
-    while (p != NULL) {
-        sscanf_s(p, "%d", &a);
-        vec.push_back(a);
-        p = strtok_s(NULL, separator, &next_token);
-    }
-    return vec;
-}
-
 
 }
 
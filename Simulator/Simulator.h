@@ -15,6 +15,8 @@
 
 #include "../Solver/Solver.h"
 #include "../Solver/Problem.h"
+#include "../Solver/InstanceReader.h"
+#include "../Solver/Geometry.h"
 #include "../Solver/Utility.h"
 
 
@@ -42,8 +44,24 @@ public:
     };
 
     struct InstanceTrait { // restrictions of data
-        Interval<int> pointNum = Interval<int>(100, 3038);
-        Interval<int> centerNum = Interval<int>(5, 500);
+        Interval<int> pointNum = Interval<int>(100, 100000);
+        Interval<int> centerNum = Interval<int>(5, 5000);
+    };
+
+    // settings of the synthetic instances. the same setting always generates the same instance.
+    struct SyntheticSetting {
+        enum Family { Geometric, Grid, Clustered };
+
+        String name() const;
+
+        Family family = Family::Geometric;
+        int nodeNum = 1000;
+        int centerNum = 10;
+        // average degree of the graph. the instance is given by coordinates if it is not positive
+        // (the Grid family is always a graph with degree 4 by default).
+        double degree = 0;
+        int clusterNum = 16; // number of clusters in the Clustered family.
+        int seed = 0;
     };
     #pragma endregion Type
 
@@ -74,24 +92,36 @@ public:
     void debug();
     // utility for testing all instances.
     void benchmark(int repeat = 1);
-    // utility for testing all instances using a thread pool.
-    void parallelBenchmark(int repeat);
+    // utility for testing all instances in parallel. the jobs are solved in process by (cores / threadNumPerJob)
+    // workers with the largest ones (by n * p) first, and the results are gathered into a single report.
+    void parallelBenchmark(int repeat = 1, int threadNumPerJob = 1, const String &reportPath = "Benchmark.csv");
+    // utility for testing all instances in a single batch of the solver.
+    void batchBenchmark(int repeat = 1, int threadNum = 0);
+
 
+    // convert the JSON instance into the binary format which is memory-mapped without parsing.
+    // the shortest path lengths are precomputed if withDistMatrix is true, otherwise the graph is stored.
+    bool convertInstance(const String &instName, bool withDistMatrix = true);
+    void convertInstances(bool withDistMatrix = true);
 
     void generateInstance(const std::string location,const int num);
     void generateInstance() {
-        std::string str1 = "D:\\vs-c\\IOstream\\instance\\pmed";
-        std::string str2 = ".txt";
         for (int i = 1; i <= 40; ++i) {
             std::stringstream location;
-            location << str1 << i << str2;
+            location << InstanceDir() << "pmed" << i << FileExtension::orLibrary();
             //std::cout << location.str() << " ";
             generateInstance(location.str(), i);
         }
         
     }
 
-    std::vector<int> Simulator::SplitString_s(const std::string& str, const char* separator);
+    // generate the synthetic instance in the instance directory. the graph is saved in JSON and
+    // binary format, while the coordinates are saved in TSPLIB and binary format.
+    bool generateInstance(const SyntheticSetting &setting);
+    // generate the instances concurrently (use all cores if threadNum is not positive).
+    void generateInstances(const List<SyntheticSetting> &settings, int threadNum = 0);
+    // all families of coordinates with n in [1000, 100000] and graphs with n in [1000, 3000].
+    void generateScalingSuite(int seed = 0);
     #pragma endregion Method
 
     #pragma region Field
@@ -1,7 +1,9 @@
 ////////////////////////////////
 /// usage : 1.	a simple hread pool without return value retrieval and argument passing.
+///         2.	submit() wraps the job with its arguments and returns the std::future of its result.
 /// 
-/// note  : 1.	
+/// note  : 1.	the WorkStealingImpl suits many short jobs. each worker has its own deque, and the idle ones
+///             steal from the others instead of contending for a single queue.
 ////////////////////////////////
 
 #ifndef JQ_CPPUTILIBS_THREAD_POOL_H
@@ -14,9 +16,19 @@
 #include <condition_variable>
 #include <vector>
 #include <queue>
+#include <memory>
+#include <future>
+#include <exception>
 #include <functional>
 #include <utility>
 
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 
 namespace szx {
 
@@ -90,6 +102,85 @@ protected:
     std::vector<Worker> workerPool;
 };
 
+// lock-free deque of job pointers (Chase and Lev, 2005) with the memory orders of Le et al. (2013).
+// only the owner pushes and takes at the bottom, and the other threads steal at the top.
+class ChaseLevDeque {
+public:
+    using Job = ThreadPoolBase::Job;
+
+
+    ChaseLevDeque() : top(0), bottom(0), buffer(new Buffer(DefaultCapacity)) { buffers.emplace_back(buffer.load()); }
+    ~ChaseLevDeque() { for (Job *job; (job = take()) != nullptr; delete job) {} }
+
+
+    void push(Job *job) {
+        long long b = bottom.load(std::memory_order_relaxed);
+        long long t = top.load(std::memory_order_acquire);
+        Buffer *buf = buffer.load(std::memory_order_relaxed);
+        if (b - t > buf->mask) { buf = grow(buf, t, b); }
+        buf->put(b, job);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    // return null if it is empty.
+    Job* take() {
+        long long b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *buf = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top.load(std::memory_order_relaxed);
+        if (t > b) { // empty.
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job *job = buf->get(b);
+        if (t == b) { // the last one may be stolen at the same time.
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) { job = nullptr; }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+    // return null if it is empty or another thread wins the race.
+    Job* steal() {
+        long long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long b = bottom.load(std::memory_order_acquire);
+        if (t >= b) { return nullptr; }
+        Job *job = buffer.load(std::memory_order_acquire)->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) ? job : nullptr;
+    }
+
+protected:
+    static constexpr long long DefaultCapacity = 64; // must be power of 2.
+
+
+    struct Buffer {
+        Buffer(long long capacity) : mask(capacity - 1), slots(new std::atomic<Job*>[static_cast<size_t>(capacity)]) {}
+
+        Job* get(long long i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(long long i, Job *job) { slots[i & mask].store(job, std::memory_order_relaxed); }
+
+        long long mask;
+        std::unique_ptr<std::atomic<Job*>[]> slots;
+    };
+
+
+    // the old buffers are kept until destruction since the thieves may still read them.
+    Buffer* grow(Buffer *buf, long long t, long long b) {
+        Buffer *newBuf = new Buffer((buf->mask + 1) * 2);
+        buffers.emplace_back(newBuf);
+        for (long long i = t; i < b; ++i) { newBuf->put(i, buf->get(i)); }
+        buffer.store(newBuf, std::memory_order_release);
+        return newBuf;
+    }
+
+
+    std::atomic<long long> top;
+    std::atomic<long long> bottom;
+    std::atomic<Buffer*> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers; // accessed by the owner only.
+};
+
 class ThreadPool {
 public:
 // [NoReturnValueRetrieval][NotExceptionSafe]
@@ -227,25 +318,223 @@ public:
         std::mutex workerMutex;
         std::condition_variable workerCv;
     };
+
+
+    // [FutureRetrieval][ExceptionSafe]
+    // [ManualStart][ManualPend][ManualStop]
+    class WorkStealingImpl : public ThreadPoolBase {
+    public:
+        // move at most this number of jobs from the shared queue to the deque of a worker at a time.
+        static constexpr Size MaxBatchSize = 32;
+
+
+        // pin the i-th worker to the (i % coreNum)-th core if pinCores is true.
+        WorkStealingImpl(Size threadNum, bool pinCores = false)
+            : ThreadPoolBase(threadNum), isPinned(pinCores), state(State::Stop) {
+            for (Size i = 0; i < threadNum; ++i) { deques.emplace_back(new ChaseLevDeque()); }
+        }
+        virtual ~WorkStealingImpl() { stop(); }
+
+
+        virtual void start() override {
+            launchedNum = 0;
+            ThreadPoolBase::start();
+        }
+        virtual void stop() override {
+            setState(State::Stop);
+            wakeAll();
+            waitAll();
+            drop(); // the futures of the dropped jobs get std::future_error.
+        }
+        virtual void pend() override {
+            setState(State::Pend);
+            wakeAll();
+            waitAll();
+            drop(); // the jobs pushed by the running jobs after the others have exited.
+        }
+
+        // the jobs pushed by a worker go to its own deque, and the others go to the shared queue.
+        virtual void push(Job &&newJob) override {
+            Job *job = new Job(std::move(newJob));
+            const Context &context(currentContext());
+            if (context.pool == this) {
+                deques[context.index]->push(job);
+            } else {
+                Lock injectLock(injectMutex);
+                injectQueue.push(job);
+            }
+            ++pendingJobNum;
+            if (sleeperNum.load() > 0) { wakeOne(); }
+        }
+
+        virtual State getState() override { return state; }
+
+        // return the first exception thrown by the pushed jobs and clear it. the jobs from submit() keep their
+        // exceptions in the futures instead.
+        std::exception_ptr takeError() {
+            Lock errorLock(errorMutex);
+            std::exception_ptr e(firstError);
+            firstError = nullptr;
+            return e;
+        }
+
+    protected:
+        struct Context {
+            const WorkStealingImpl *pool = nullptr;
+            Size index = 0;
+        };
+
+
+        static Context& currentContext() {
+            thread_local Context context;
+            return context;
+        }
+
+        static void pinCurrentThread(Size index) {
+            Size coreNum = (std::max)(getDefaultWorkerNum(), 1);
+            #ifdef _WIN32
+            SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (index % coreNum % (sizeof(DWORD_PTR) * 8)));
+            #elif defined(__linux__)
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(index % coreNum, &cpus);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+            #endif
+        }
+
+
+        virtual void work() override {
+            Size index = launchedNum++;
+            Context &context(currentContext());
+            context.pool = this;
+            context.index = index;
+            if (isPinned) { pinCurrentThread(index); }
+
+            for (;;) {
+                if (state == State::Stop) { break; }
+                Job *job = deques[index]->take();
+                if (!job) { job = takeInjected(index); }
+                if (!job) { job = steal(index); }
+                if (job) {
+                    --pendingJobNum;
+                    run(job);
+                    continue;
+                }
+
+                Lock idleLock(idleMutex);
+                ++sleeperNum;
+                idleCv.wait(idleLock, [this]() { return (pendingJobNum.load() > 0) || (state != State::Run); });
+                --sleeperNum;
+                if ((pendingJobNum.load() <= 0) && (state != State::Run)) { break; } // all pending jobs finished.
+            }
+            context.pool = nullptr;
+        }
+
+        virtual void setState(State newState) override { state = newState; }
+
+        // take one job and move a batch of the rest to the deque of the worker.
+        Job* takeInjected(Size index) {
+            Lock injectLock(injectMutex);
+            if (injectQueue.empty()) { return nullptr; }
+            Job *job = injectQueue.front();
+            injectQueue.pop();
+            Size batchSize = static_cast<Size>(injectQueue.size() / workerPool.size());
+            if (batchSize > MaxBatchSize) { batchSize = MaxBatchSize; }
+            for (Size i = 0; i < batchSize; ++i) {
+                deques[index]->push(injectQueue.front());
+                injectQueue.pop();
+            }
+            return job;
+        }
+
+        Job* steal(Size index) {
+            Size workerNum = static_cast<Size>(deques.size());
+            for (Size i = 1; i < workerNum; ++i) {
+                Job *job = deques[(index + i) % workerNum]->steal();
+                if (job) { return job; }
+            }
+            return nullptr;
+        }
+
+        void run(Job *job) {
+            try {
+                (*job)();
+            } catch (...) {
+                Lock errorLock(errorMutex);
+                if (!firstError) { firstError = std::current_exception(); }
+            }
+            delete job;
+        }
+
+        void drop() {
+            for (auto d = deques.begin(); d != deques.end(); ++d) {
+                for (Job *job; (job = (*d)->take()) != nullptr; delete job) { --pendingJobNum; }
+            }
+            Lock injectLock(injectMutex);
+            for (; !injectQueue.empty(); injectQueue.pop()) {
+                delete injectQueue.front();
+                --pendingJobNum;
+            }
+        }
+
+        // the lock pairs with the predicate check of the sleeping workers so that no notification is lost.
+        void wakeOne() {
+            { Lock idleLock(idleMutex); }
+            idleCv.notify_one();
+        }
+        void wakeAll() {
+            { Lock idleLock(idleMutex); }
+            idleCv.notify_all();
+        }
+
+
+        bool isPinned;
+        std::atomic<State> state;
+        std::atomic<Size> launchedNum;
+        std::atomic<Size> pendingJobNum{ 0 }; // pushed but not taken yet.
+        std::atomic<Size> sleeperNum{ 0 };
+
+        std::vector<std::unique_ptr<ChaseLevDeque>> deques; // deques[i] is owned by the i-th worker.
+        std::queue<Job*> injectQueue; // the jobs pushed by the other threads.
+        std::mutex injectMutex;
+
+        std::mutex idleMutex;
+        std::condition_variable idleCv;
+
+        std::mutex errorMutex;
+        std::exception_ptr firstError;
+    };
 };
 
 }
 
-// [NoReturnValueRetrieval][NotExceptionSafe]
+// [FutureRetrieval][ExceptionSafe for submit()]
 // [AutoStart][AutoPend][ManualStop]
 template<typename ThreadPoolImpl = impl::ThreadPool::QueueImpl>
 class ThreadPool : public ThreadPoolImpl {
 public:
-    ThreadPool(int threadNum) : ThreadPoolImpl(threadNum) { start(); }
-    ThreadPool() : ThreadPool(getDefaultWorkerNum()) {}
-    virtual ~ThreadPool() { pend(); }
+    // the extra arguments are passed to the implementation, e.g., pinCores of the WorkStealingImpl.
+    template<typename ...ImplArgs>
+    ThreadPool(int threadNum, ImplArgs &&...implArgs) : ThreadPoolImpl(threadNum, std::forward<ImplArgs>(implArgs)...) { this->start(); }
+    ThreadPool() : ThreadPool(ThreadPoolImpl::getDefaultWorkerNum()) {}
+    virtual ~ThreadPool() { this->pend(); }
 
 
     using ThreadPoolImpl::push;
     // avoid copying function objects. the const reference can be handled automatically.
     template<typename Functor>
     void push(Functor &newJob) { push(std::ref(newJob)); } // or use `push([&newJob]() { newJob(); });`.
-    // EXTEND[szx][9]: provide std::future?
+
+    // the arguments are copied. the exception thrown by the job is rethrown by std::future::get().
+    template<typename Functor, typename ...Args>
+    auto submit(Functor &&newJob, Args &&...args) -> std::future<decltype(newJob(args...))> {
+        using Result = decltype(newJob(args...));
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::bind(std::forward<Functor>(newJob), std::forward<Args>(args)...));
+        std::future<Result> result(task->get_future());
+        push([task]() { (*task)(); });
+        return result;
+    }
 };
 
 }
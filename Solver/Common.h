@@ -43,6 +43,9 @@ class FileExtension {
 public:
     static String protobuf() { return String(".pb"); }
     static String json() { return String(".json"); }
+    static String binary() { return String(".bin"); }
+    static String orLibrary() { return String(".txt"); }
+    static String tsplib() { return String(".tsp"); }
 };
 
 }
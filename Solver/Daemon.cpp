@@ -0,0 +1,411 @@
+#include "Daemon.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if !_OS_MS_WINDOWS
+#include <csignal>
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif // _OS_MS_WINDOWS
+
+#include "InstanceReader.h"
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+namespace {
+
+// FNV-1a (Fowler et al.).
+constexpr unsigned long long FnvOffset = 14695981039346656037ull;
+unsigned long long fnv(const char *begin, const char *end, unsigned long long h = FnvOffset) {
+    constexpr unsigned long long Prime = 1099511628211ull;
+    for (; begin != end; ++begin) { h = (h ^ static_cast<unsigned char>(*begin)) * Prime; }
+    return h;
+}
+template<typename T>
+unsigned long long fnv(const T &obj, unsigned long long h) {
+    return fnv(reinterpret_cast<const char*>(&obj), reinterpret_cast<const char*>(&obj) + sizeof(obj), h);
+}
+
+String errorEvent(const String &message) {
+    ostringstream oss;
+    oss << "{\"event\":\"error\",\"message\":\"";
+    for (auto c = message.begin(); c != message.end(); ++c) {
+        if ((*c == '"') || (*c == '\\')) { oss << '\\'; }
+        oss << *c;
+    }
+    oss << "\"}";
+    return oss.str();
+}
+
+#if !_OS_MS_WINDOWS
+bool readAll(int fd, char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t len = recv(fd, buf, size, 0);
+        if (len < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        if (len == 0) { return false; } // closed by the peer.
+        buf += len;
+        size -= len;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t len = send(fd, buf, size, 0);
+        if (len < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        buf += len;
+        size -= len;
+    }
+    return true;
+}
+
+bool readMessage(int fd, String &msg) {
+    unsigned char prefix[4];
+    if (!readAll(fd, reinterpret_cast<char*>(prefix), sizeof(prefix))) { return false; }
+    unsigned size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<unsigned>(prefix[3]) << 24);
+    if (size > Daemon::MaxMessageSize) { return false; }
+    msg.resize(size);
+    return readAll(fd, &msg[0], size);
+}
+
+bool writeMessage(int fd, const String &msg) {
+    unsigned size = static_cast<unsigned>(msg.size());
+    unsigned char prefix[4] = {
+        static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size >> 16), static_cast<unsigned char>(size >> 24)
+    };
+    return writeAll(fd, reinterpret_cast<const char*>(prefix), sizeof(prefix)) && writeAll(fd, msg.data(), msg.size());
+}
+
+// cancel the token once the peer closes the connection, until isDone is set. only POLLHUP is watched since
+// a client may shut down its writing side and still wait for the result.
+void watchHangUp(int fd, const atomic<bool> &isDone, CancellationToken &hangUp) {
+    constexpr int PollIntervalInMillisecond = 100;
+    pollfd pfd = { fd, 0, 0 }; // POLLHUP and POLLERR are always reported.
+    while (!isDone.load()) {
+        if ((poll(&pfd, 1, PollIntervalInMillisecond) > 0) && (pfd.revents & (POLLHUP | POLLERR))) {
+            hangUp.cancel();
+            return;
+        }
+    }
+}
+#endif // _OS_MS_WINDOWS
+
+}
+
+
+bool Daemon::Request::parse(const String &msg, String &error) {
+    size_t pos = 0;
+    while (pos < msg.size()) {
+        size_t eol = msg.find('\n', pos);
+        if (eol == String::npos) { eol = msg.size(); }
+        String line(msg, pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+        if (line.empty()) { break; } // the rest is the inline instance.
+
+        size_t space = line.find(' ');
+        String key(line, 0, space);
+        String value((space == String::npos) ? "" : line.substr(space + 1));
+        if (key == "instance") {
+            instPath = value;
+        } else if (key == "format") {
+            format = value;
+        } else if (key == "cached") {
+            cacheKey = value;
+        } else if (key == "edge") {
+            Problem::Edge e;
+            if (sscanf(value.c_str(), "%d %d %d", &e.source, &e.target, &e.length) != 3) {
+                error = "invalid edge " + value;
+                return false;
+            }
+            --e.source;
+            --e.target;
+            delta.push_back(e);
+        } else if (key == "init") {
+            istringstream iss(value);
+            for (ID c; iss >> c;) { initCenters.push_back(c - 1); }
+        } else if (key == "centers") {
+            centerNum = atoi(value.c_str());
+        } else if (key == "timeout") {
+            timeout = atof(value.c_str());
+        } else if (key == "seed") {
+            randSeed = atoi(value.c_str());
+        } else if (key == "threads") {
+            threadNum = atoi(value.c_str());
+        } else if (key == "progress") {
+            progress = (atoi(value.c_str()) != 0);
+        } else {
+            error = "unknown key " + key;
+            return false;
+        }
+    }
+
+    if ((!instPath.empty() + !format.empty() + !cacheKey.empty()) != 1) {
+        error = "one of instance, format and cached should be given";
+        return false;
+    }
+    if (!format.empty()) {
+        if ((format != "json") && (format != "txt") && (format != "tsp")) {
+            error = "unsupported format " + format;
+            return false;
+        }
+        if (pos < msg.size()) { body.assign(msg, pos, String::npos); }
+    }
+    if (threadNum <= 0) { threadNum = 1; }
+    return true;
+}
+
+bool Daemon::run(const String &socketPath) {
+    #if _OS_MS_WINDOWS
+    Log(LogSwitch::Szx::Framework) << "the daemon mode is not supported on this platform." << endl;
+    return false;
+    #else
+    signal(SIGPIPE, SIG_IGN); // the broken connections are detected by the return value of send().
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        Log(LogSwitch::Szx::Framework) << "the socket path is too long." << endl;
+        return false;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) { return false; }
+    unlink(socketPath.c_str()); // remove the socket left by the previous run.
+    if ((bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) || (listen(listener, SOMAXCONN) < 0)) {
+        Log(LogSwitch::Szx::Framework) << "fail to listen on " << socketPath << endl;
+        close(listener);
+        return false;
+    }
+
+    Log(LogSwitch::Szx::Framework) << "listen on " << socketPath << endl;
+    for (;;) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        thread([this, connection]() { serve(connection); }).detach();
+    }
+    close(listener);
+    return false;
+    #endif // _OS_MS_WINDOWS
+}
+
+void Daemon::serve(int connection) {
+    #if !_OS_MS_WINDOWS
+    mutex sendMutex;
+    bool isBroken = false;
+    CancellationToken hangUp;
+    auto send = [&](const String &msg) {
+        lock_guard<mutex> sendGuard(sendMutex);
+        if (!isBroken) { isBroken = !writeMessage(connection, msg); }
+        return !isBroken;
+    };
+
+    for (String msg; !isBroken && !hangUp.isCancelled() && readMessage(connection, msg);) {
+        Request req;
+        String error;
+        if (req.parse(msg, error)) {
+            // nothing is sent during the solve without the progress stream, so the hang-up is watched instead.
+            atomic<bool> isDone(false);
+            thread watcher([&]() { watchHangUp(connection, isDone, hangUp); });
+            handle(req, send, &hangUp);
+            isDone = true;
+            watcher.join();
+        } else {
+            send(errorEvent(error));
+        }
+    }
+    close(connection);
+    #endif // _OS_MS_WINDOWS
+}
+
+void Daemon::handle(const Request &req, const function<bool(const String &msg)> &send, const CancellationToken *hangUp) {
+    Timer::TimePoint begin = Timer::Clock::now();
+
+    InstanceKey key;
+    bool isCached;
+    String error;
+    shared_ptr<Instance> instance(fetch(req, key, isCached, error));
+    if (!instance) {
+        send(errorEvent(error));
+        return;
+    }
+    ID centerNum = (req.centerNum > 0) ? req.centerNum : instance->input.centernum();
+    if ((centerNum <= 0) || (centerNum > instance->input.nodeNum)) {
+        send(errorEvent("invalid number of centers"));
+        return;
+    }
+
+    String instName(req.instPath.empty() ? ("inline." + req.format) : req.instPath);
+    Solver::Environment env(instName, "", req.randSeed, req.timeout, Solver::Environment::DefaultMaxIter, req.threadNum);
+    env.centerNum = centerNum;
+    env.calibrate();
+    Solver solver(instance->input, env, cfg);
+    solver.aux.table = instance->table;
+    solver.initCenters = req.initCenters;
+    solver.cancellation.link(hangUp);
+    if (req.progress) {
+        solver.progress.redirect([&](const String &line) {
+            if (!send(line)) { solver.cancellation.cancel(); } // nobody is waiting for the result.
+        });
+    }
+    if (!solver.solve()) {
+        send(errorEvent("no solution is found"));
+        return;
+    }
+
+    ostringstream oss;
+    oss << fixed << setprecision(3)
+        << "{\"event\":\"result\",\"obj\":" << solver.output.maxLength << ",\"centers\":[";
+    for (int i = 0; i < solver.output.centers_size(); ++i) { oss << ((i > 0) ? "," : "") << solver.output.centers(i); }
+    oss << "],\"time\":" << chrono::duration<double>(Timer::Clock::now() - begin).count()
+        << ",\"cached\":" << (isCached ? "true" : "false")
+        << ",\"key\":\"" << hex << setw(16) << setfill('0') << key << "\"}";
+    send(oss.str());
+}
+
+shared_ptr<Daemon::Instance> Daemon::fetch(const Request &req, InstanceKey &key, bool &isCached, String &error) {
+    shared_ptr<Instance> instance;
+    if (!req.cacheKey.empty()) {
+        key = strtoull(req.cacheKey.c_str(), nullptr, 16);
+        lock_guard<mutex> cacheGuard(cacheMutex);
+        auto entry = cache.find(key);
+        if (entry != cache.end()) {
+            recencies.splice(recencies.begin(), recencies, entry->second.recency);
+            instance = entry->second.instance;
+        }
+        isCached = true;
+        if (!instance || !instance->isLoaded) { // evicted or being loaded.
+            error = "instance " + req.cacheKey + " is not in the cache";
+            return nullptr;
+        }
+    } else {
+        MemoryMappedFile file;
+        String format(req.format);
+        const char *begin = req.body.data();
+        const char *end = begin + req.body.size();
+        if (!req.instPath.empty()) {
+            if (!file.open(req.instPath)) {
+                error = "fail to open " + req.instPath;
+                return nullptr;
+            }
+            begin = file.data();
+            end = begin + file.size();
+            size_t dot = req.instPath.find_last_of('.');
+            if (dot != String::npos) { format = req.instPath.substr(dot + 1); }
+        }
+        key = fnv(begin, end, fnv(format.data(), format.data() + format.size()));
+
+        instance = fetch(key, isCached, [&](Instance &inst) {
+            if (!req.instPath.empty()) { return inst.input.load(req.instPath); }
+            if (format == "json") { return InstanceReader::parseJson(begin, end, inst.input); }
+            if (format == "txt") { return InstanceReader::parseOrLibrary(begin, end, inst.input); }
+            return InstanceReader::parseTsplib(begin, end, inst.input);
+        });
+        if (!instance) {
+            error = "fail to load the instance";
+            return nullptr;
+        }
+    }
+    if (req.delta.empty()) { return instance; }
+
+    // the changed graph is derived from the original instance without loading it again.
+    for (auto e = req.delta.begin(); e != req.delta.end(); ++e) {
+        key = fnv(e->length, fnv(e->target, fnv(e->source, key)));
+    }
+    shared_ptr<Instance> original(instance);
+    instance = fetch(key, isCached, [&](Instance &inst) {
+        inst.input = original->input;
+        Solver::DistanceTable table(*original->table);
+        if (!Solver::updateGraph(inst.input, req.delta, table)) { return false; }
+        inst.table = make_shared<Solver::DistanceTable>(move(table));
+        return true;
+    });
+    if (!instance) { error = "fail to change the edges of the instance"; }
+    return instance;
+}
+
+shared_ptr<Daemon::Instance> Daemon::fetch(InstanceKey key, bool &isCached, const function<bool(Instance &instance)> &load) {
+    shared_ptr<Instance> instance;
+    {
+        lock_guard<mutex> cacheGuard(cacheMutex);
+        auto entry = cache.find(key);
+        isCached = (entry != cache.end());
+        if (isCached) {
+            recencies.splice(recencies.begin(), recencies, entry->second.recency);
+            instance = entry->second.instance;
+        } else {
+            instance = make_shared<Instance>();
+            recencies.push_front(key);
+            cache[key] = { instance, recencies.begin() };
+        }
+    }
+
+    call_once(instance->loadFlag, [&]() {
+        if (!load(*instance)) { return; }
+        const Problem::Input &input(instance->input);
+        if (!instance->table) {
+            shared_ptr<Solver::DistanceTable> table(make_shared<Solver::DistanceTable>());
+            Solver::buildDistanceTable(input, cfg, 1, *table);
+            instance->table = table;
+        }
+
+        lock_guard<mutex> cacheGuard(cacheMutex);
+        instance->isLoaded = true; // it is read under the lock by the requests on the cache key.
+        instance->size = instance->table->memoryUsage() + input.edgeList.capacity() * sizeof(Problem::Edge)
+            + (input.xCoords.capacity() + input.yCoords.capacity()) * sizeof(double);
+        auto entry = cache.find(key);
+        if ((entry != cache.end()) && (entry->second.instance == instance)) {
+            cacheSize += instance->size;
+            evict();
+        }
+    });
+
+    if (!instance->isLoaded) {
+        lock_guard<mutex> cacheGuard(cacheMutex);
+        auto entry = cache.find(key);
+        if ((entry != cache.end()) && (entry->second.instance == instance)) {
+            recencies.erase(entry->second.recency);
+            cache.erase(entry);
+        }
+        return nullptr;
+    }
+    return instance;
+}
+
+void Daemon::evict() {
+    // the most recent one is kept even if it exceeds the capacity alone.
+    while ((cacheSize > cacheCapacity) && (recencies.size() > 1)) {
+        auto entry = cache.find(recencies.back());
+        Log(LogSwitch::Szx::Framework) << "drop instance " << hex << entry->first << dec << " from the cache." << endl;
+        cacheSize -= entry->second.instance->size;
+        recencies.pop_back();
+        cache.erase(entry);
+    }
+}
+
+}
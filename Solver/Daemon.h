@@ -0,0 +1,115 @@
+////////////////////////////////
+/// usage : 1.	serve the solving requests over a Unix domain socket, keeping the parsed instances and
+///             their distance tables in memory for the following requests on the same instance.
+///
+/// note  : 1.	each message is a 4-byte little-endian payload length followed by the payload.
+///         2.	a request is lines of "key value", then an empty line and the inline instance if any.
+///             instance path     : the instance file (.json, .bin, .txt or .tsp).
+///             format ext        : the body is the inline instance in the format of the extension (json, txt or tsp).
+///             cached key        : the instance in the cache with the key returned by a previous request.
+///             edge u v length   : replace the edges between node u and v, or remove them if the length is negative.
+///                                 the changed graph is cached as a new instance with the repaired distance table.
+///             init c1 c2 ...    : start from the given centers, e.g., the solution before the edge changes.
+///             centers int       : number of centers. it overrides the one in the instance.
+///             timeout seconds   : time budget of the request. it is 60 by default.
+///             seed int          : rand seed of the request.
+///             threads int       : number of threads of the request. it is 1 by default.
+///             progress 0|1      : stream the improvements and heartbeats before the result. it is 1 by default.
+///         3.	each response message is a JSON object, i.e., the events of the progress stream,
+///             then a "result" or "error" event which ends the request.
+///         4.	a connection sends its requests in sequence, and the connections are served concurrently.
+///         5.	the instances are identified by the hash of their contents, or the hash of the original
+///             instance and the edge changes. the key is returned in the result in hex.
+////////////////////////////////
+
+#ifndef SMART_JQ_PCENTER_DAEMON_H
+#define SMART_JQ_PCENTER_DAEMON_H
+
+
+#include "Config.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include "Common.h"
+#include "Problem.h"
+#include "Solver.h"
+
+
+namespace szx {
+
+class Daemon {
+public:
+    static constexpr unsigned MaxMessageSize = (1u << 30);
+
+    struct Request {
+        // return false with the reason in error if the message is malformed.
+        bool parse(const String &msg, String &error);
+
+        String instPath;
+        String format; // extension of the inline instance in body. it is empty if the instance is given by path.
+        String body;
+        String cacheKey;
+        List<Problem::Edge> delta; // zero-based node IDs.
+        List<ID> initCenters; // zero-based node IDs.
+        int centerNum = 0;
+        double timeout = Solver::Environment::DefaultTimeout;
+        int randSeed = Random::generateSeed();
+        int threadNum = 1;
+        bool progress = true;
+    };
+
+
+    Daemon(const Solver::Configuration &config) : cfg(config),
+        cacheCapacity(static_cast<size_t>(config.cacheSizeInMegabytes) << 20) {}
+
+    // serve forever. it returns false if the socket can not be listened on.
+    bool run(const String &socketPath);
+
+    // solve the request and send the responses. the message sender is called by one thread at a time, and it returns
+    // false once the connection is broken. the solve is cancelled then, or once the hangUp token is cancelled.
+    void handle(const Request &req, const std::function<bool(const String &msg)> &send,
+        const CancellationToken *hangUp = nullptr);
+
+protected:
+    using InstanceKey = unsigned long long;
+
+    struct Instance {
+        std::once_flag loadFlag;
+        bool isLoaded = false; // written under the cacheMutex.
+        Problem::Input input;
+        std::shared_ptr<const Solver::DistanceTable> table;
+        size_t size = 0; // memory usage in bytes.
+    };
+
+    struct CacheEntry {
+        std::shared_ptr<Instance> instance;
+        std::list<InstanceKey>::iterator recency;
+    };
+
+
+    void serve(int connection);
+
+    // find the instance of the request in the cache or load it. isCached is false if it is loaded by this call.
+    std::shared_ptr<Instance> fetch(const Request &req, InstanceKey &key, bool &isCached, String &error);
+    // find the instance in the cache or add it by the loader. the concurrent requests on the same new instance
+    // wait for the first one to load it. it returns null if the loader fails.
+    std::shared_ptr<Instance> fetch(InstanceKey key, bool &isCached, const std::function<bool(Instance &instance)> &load);
+    // drop the least recently used instances until the rest fit in the capacity. the cacheMutex is held.
+    void evict();
+
+
+    Solver::Configuration cfg;
+
+    size_t cacheCapacity; // in bytes.
+    size_t cacheSize = 0;
+    std::mutex cacheMutex;
+    std::list<InstanceKey> recencies; // the most recently used one is at front.
+    Map<InstanceKey, CacheEntry> cache;
+};
+
+}
+
+
+#endif // SMART_JQ_PCENTER_DAEMON_H
@@ -0,0 +1,181 @@
+#include "Geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace szx {
+
+namespace {
+
+using Metric = Problem::Metric;
+
+double toGeoRadian(double coord) {
+    constexpr double Pi = 3.141592; // the truncated value in the definition.
+    int deg = static_cast<int>(coord);
+    return Pi * (deg + 5.0 * (coord - deg) / 3.0) / 180.0;
+}
+
+constexpr double EarthRadius = 6378.388;
+
+Length geoLength(double x0, double y0, double x1, double y1) {
+    double q1 = cos(y0 - y1);
+    double q2 = cos(x0 - x1);
+    double q3 = cos(x0 + x1);
+    return static_cast<Length>(EarthRadius * acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+}
+
+// the length of vector (dx, dy) in the planar metrics.
+template<Metric M>
+Length planarLength(double dx, double dy);
+template<>
+Length planarLength<Metric::Euc2d>(double dx, double dy) { return static_cast<Length>(sqrt(dx * dx + dy * dy) + 0.5); }
+template<>
+Length planarLength<Metric::Ceil2d>(double dx, double dy) { return static_cast<Length>(ceil(sqrt(dx * dx + dy * dy))); }
+template<>
+Length planarLength<Metric::Att>(double dx, double dy) {
+    double r = sqrt((dx * dx + dy * dy) / 10.0);
+    Length t = static_cast<Length>(r + 0.5);
+    return (t < r) ? (t + 1) : t;
+}
+template<>
+Length planarLength<Metric::Man2d>(double dx, double dy) { return static_cast<Length>(fabs(dx) + fabs(dy) + 0.5); }
+template<>
+Length planarLength<Metric::Max2d>(double dx, double dy) { return static_cast<Length>((max)(fabs(dx), fabs(dy)) + 0.5); }
+
+Length planarLength(Metric metric, double dx, double dy) {
+    switch (metric) {
+    case Metric::Euc2d: return planarLength<Metric::Euc2d>(dx, dy);
+    case Metric::Ceil2d: return planarLength<Metric::Ceil2d>(dx, dy);
+    case Metric::Att: return planarLength<Metric::Att>(dx, dy);
+    case Metric::Man2d: return planarLength<Metric::Man2d>(dx, dy);
+    case Metric::Max2d: return planarLength<Metric::Max2d>(dx, dy);
+    default: return 0;
+    }
+}
+
+template<Metric M>
+void planarRow(const double *xs, const double *ys, ID nodeNum, double ux, double uy, Length *dist) {
+    for (ID v = 0; v < nodeNum; ++v) { dist[v] = planarLength<M>(xs[v] - ux, ys[v] - uy); }
+}
+
+}
+
+
+void DistanceOracle::init(const Problem::Input &input) {
+    metric = input.metric;
+    x = input.xCoords;
+    y = input.yCoords;
+    if (metric == Metric::Geo) {
+        for (auto c = x.begin(); c != x.end(); ++c) { *c = toGeoRadian(*c); }
+        for (auto c = y.begin(); c != y.end(); ++c) { *c = toGeoRadian(*c); }
+    }
+}
+
+Length DistanceOracle::operator()(ID u, ID v) const {
+    if (metric == Metric::Geo) { return (u == v) ? 0 : geoLength(x[u], y[u], x[v], y[v]); }
+    return planarLength(metric, x[v] - x[u], y[v] - y[u]);
+}
+
+void DistanceOracle::row(ID u, Length *dist) const {
+    const double *xs = x.data();
+    const double *ys = y.data();
+    ID n = nodeNum();
+    switch (metric) {
+    case Metric::Euc2d: planarRow<Metric::Euc2d>(xs, ys, n, x[u], y[u], dist); break;
+    case Metric::Ceil2d: planarRow<Metric::Ceil2d>(xs, ys, n, x[u], y[u], dist); break;
+    case Metric::Att: planarRow<Metric::Att>(xs, ys, n, x[u], y[u], dist); break;
+    case Metric::Man2d: planarRow<Metric::Man2d>(xs, ys, n, x[u], y[u], dist); break;
+    case Metric::Max2d: planarRow<Metric::Max2d>(xs, ys, n, x[u], y[u], dist); break;
+    case Metric::Geo:
+        for (ID v = 0; v < n; ++v) { dist[v] = geoLength(x[u], y[u], xs[v], ys[v]); }
+        dist[u] = 0;
+        break;
+    default: fill(dist, dist + n, 0); break;
+    }
+}
+
+Length DistanceOracle::lowerBound(double gap) const {
+    // the planar metrics are monotone in both |dx| and |dy|. the central angle is at least the latitude gap,
+    // and the GEO lengths are rounded up, so flooring keeps it a lower bound.
+    return (metric == Metric::Geo) ? static_cast<Length>(EarthRadius * gap) : planarLength(metric, gap, 0);
+}
+
+
+void SpatialGrid::init(const DistanceOracle &distOracle, int nodeNumPerCell) {
+    oracle = &distOracle;
+    const List<double> &x(oracle->xCoords());
+    const List<double> &y(oracle->yCoords());
+    ID nodeNum = oracle->nodeNum();
+    if (nodeNum <= 0) { return; }
+
+    auto xRange = minmax_element(x.begin(), x.end());
+    auto yRange = minmax_element(y.begin(), y.end());
+    minX = *xRange.first;
+    minY = *yRange.first;
+    double width = *xRange.second - minX;
+    double height = *yRange.second - minY;
+    int cellNum = (max)(1, nodeNum / (max)(1, nodeNumPerCell));
+    // there are at most 3 * cellNum + 1 cells even if the nodes are on a line.
+    cellSize = (max)(sqrt(width * height / cellNum), (max)(width, height) / cellNum);
+    if (cellSize <= 0) { cellSize = 1; }
+    colNum = static_cast<int>(width / cellSize) + 1;
+    rowNum = static_cast<int>(height / cellSize) + 1;
+
+    // counting sort the nodes by their cells.
+    List<ID> cellOfNode(nodeNum);
+    cellOffsets.assign(colNum * rowNum + 1, 0);
+    for (ID n = 0; n < nodeNum; ++n) {
+        cellOfNode[n] = cellOf(y[n], minY, rowNum) * colNum + cellOf(x[n], minX, colNum);
+        ++cellOffsets[cellOfNode[n] + 1];
+    }
+    for (size_t c = 1; c < cellOffsets.size(); ++c) { cellOffsets[c] += cellOffsets[c - 1]; }
+    cellNodes.resize(nodeNum);
+    List<ID> next(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (ID n = 0; n < nodeNum; ++n) { cellNodes[next[cellOfNode[n]]++] = n; }
+}
+
+void SpatialGrid::nearest(ID u, int k, List<ID> &result) const {
+    const List<double> &x(oracle->xCoords());
+    const List<double> &y(oracle->yCoords());
+    k = (min)(k, oracle->nodeNum());
+    int cx = cellOf(x[u], minX, colNum);
+    int cy = cellOf(y[u], minY, rowNum);
+    bool isPlanar = oracle->isPlanar();
+    int maxRing = (max)(cx, colNum - 1 - cx);
+    if (isPlanar) { maxRing = (max)(maxRing, (max)(cy, rowNum - 1 - cy)); }
+
+    List<pair<Length, ID>> candidates;
+    for (int r = 0; r <= maxRing; ++r) {
+        int firstRow = isPlanar ? (max)(0, cy - r) : 0;
+        int lastRow = isPlanar ? (min)(rowNum - 1, cy + r) : (rowNum - 1);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            // only the first and last rows of the ring are full.
+            int step = ((r == 0) || (isPlanar && ((row == cy - r) || (row == cy + r)))) ? 1 : (2 * r);
+            for (int col = cx - r; col <= cx + r; col += step) {
+                if ((col < 0) || (col >= colNum)) { continue; }
+                int cell = row * colNum + col;
+                for (ID i = cellOffsets[cell]; i < cellOffsets[cell + 1]; ++i) {
+                    candidates.push_back({ (*oracle)(u, cellNodes[i]), cellNodes[i] });
+                }
+            }
+        }
+        // the nodes outside the ring are at least r cells away in x or y (only x for GEO).
+        if (static_cast<int>(candidates.size()) < k) { continue; }
+        nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+        if (candidates[k - 1].first <= oracle->lowerBound(r * cellSize)) { break; }
+    }
+
+    partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+    result.resize(k);
+    for (int i = 0; i < k; ++i) { result[i] = candidates[i].second; }
+}
+
+int SpatialGrid::cellOf(double coord, double origin, int cellNum) const {
+    return (min)(cellNum - 1, (max)(0, static_cast<int>((coord - origin) / cellSize)));
+}
+
+}
@@ -0,0 +1,73 @@
+////////////////////////////////
+/// usage : 1.	distance oracle and spatial index for the instances given by coordinates.
+///
+/// note  : 1.	the distances are computed on demand, so large instances need no n*n matrix.
+////////////////////////////////
+
+#ifndef SMART_JQ_PCENTER_GEOMETRY_H
+#define SMART_JQ_PCENTER_GEOMETRY_H
+
+
+#include "Config.h"
+
+#include <vector>
+#include "Common.h"
+#include "Problem.h"
+
+
+namespace szx {
+
+// compute the distances between nodes by the metric of the input.
+class DistanceOracle {
+public:
+    void init(const Problem::Input &input);
+
+    Length operator()(ID u, ID v) const;
+    // the distances from node u to all nodes. the metric is dispatched once per row
+    // instead of once per distance, and each metric is a plain scalar loop.
+    void row(ID u, Length *dist) const;
+    // the distance is not less than it if the coordinates differ by gap in x or y.
+    // for GEO, it only holds for x, i.e., the latitude, since the longitude wraps and shrinks toward the poles.
+    Length lowerBound(double gap) const;
+    bool isPlanar() const { return metric != Problem::Metric::Geo; }
+
+    ID nodeNum() const { return static_cast<ID>(x.size()); }
+    const List<double>& xCoords() const { return x; }
+    const List<double>& yCoords() const { return y; }
+
+protected:
+    Problem::Metric metric = Problem::Metric::Explicit;
+    List<double> x; // the latitude in radians for GEO.
+    List<double> y; // the longitude in radians for GEO.
+};
+
+// uniform grid over the bounding box of the nodes.
+class SpatialGrid {
+public:
+    static constexpr int DefaultNodeNumPerCell = 2;
+
+
+    void init(const DistanceOracle &distOracle, int nodeNumPerCell = DefaultNodeNumPerCell);
+
+    // the k nearest nodes to node u in ascending order of the distance (u itself included).
+    // the cells are visited ring by ring until the unvisited ones can not be closer.
+    // the rings are full columns for GEO since only the latitude gap bounds the distance.
+    void nearest(ID u, int k, List<ID> &result) const;
+
+protected:
+    int cellOf(double coord, double origin, int cellNum) const;
+
+    const DistanceOracle *oracle = nullptr;
+    double minX = 0;
+    double minY = 0;
+    double cellSize = 1;
+    int colNum = 1;
+    int rowNum = 1;
+    List<ID> cellOffsets; // the nodes in cell c are cellNodes[cellOffsets[c], cellOffsets[c + 1]).
+    List<ID> cellNodes;
+};
+
+}
+
+
+#endif // SMART_JQ_PCENTER_GEOMETRY_H
@@ -0,0 +1,544 @@
+#include "InstanceReader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "LogSwitch.h"
+
+
+using namespace std;
+
+
+namespace szx {
+
+constexpr char InstanceReader::BinaryMagic[];
+
+namespace {
+
+const char* skipSpace(const char *s, const char *end) {
+    while ((s != end) && ((*s == ' ') || (*s == '\n') || (*s == '\r') || (*s == '\t'))) { ++s; }
+    return s;
+}
+
+// protobuf also accepts integers in quotes. the ones out of the int range are rejected.
+bool parseInt(const char *&s, const char *end, int &value) {
+    bool quoted = ((s != end) && (*s == '"'));
+    if (quoted) { ++s; }
+    bool negative = ((s != end) && (*s == '-'));
+    if (negative) { ++s; }
+    if ((s == end) || (*s < '0') || (*s > '9')) { return false; }
+    for (value = 0; (s != end) && (*s >= '0') && (*s <= '9'); ++s) {
+        int digit = *s - '0';
+        if (value > (INT_MAX - digit) / 10) { return false; }
+        value = value * 10 + digit;
+    }
+    if (negative) { value = -value; }
+    if (quoted) {
+        if ((s == end) || (*s != '"')) { return false; }
+        ++s;
+    }
+    return true;
+}
+
+bool isKey(const char *key, size_t len, const char *name) {
+    return (len == strlen(name)) && (memcmp(key, name, len) == 0);
+}
+
+bool hasExtension(const String &path, const String &ext) {
+    return (path.size() > ext.size()) && (path.compare(path.size() - ext.size(), ext.size(), ext) == 0);
+}
+
+// whitespace separated tokens in a buffer which is not null-terminated.
+class Tokenizer {
+public:
+    Tokenizer(const char *begin, const char *end) : cur(begin), end(end) {}
+
+    bool eof() {
+        cur = skipSpace(cur, end);
+        return (cur == end);
+    }
+
+    bool nextInt(int &value) {
+        cur = skipSpace(cur, end);
+        return parseInt(cur, end, value);
+    }
+
+    // decimal or scientific notation.
+    bool nextReal(double &value) {
+        cur = skipSpace(cur, end);
+        bool negative = ((cur != end) && ((*cur == '-') || (*cur == '+'))) ? (*cur++ == '-') : false;
+        const char *begin = cur;
+        for (value = 0; (cur != end) && isDigit(*cur); ++cur) { value = value * 10 + (*cur - '0'); }
+        if ((cur != end) && (*cur == '.')) {
+            double base = 0.1;
+            for (++cur; (cur != end) && isDigit(*cur); ++cur, base /= 10) { value += base * (*cur - '0'); }
+        }
+        if (cur == begin) { return false; }
+        if ((cur != end) && ((*cur == 'e') || (*cur == 'E'))) {
+            ++cur;
+            bool negativeExp = ((cur != end) && ((*cur == '-') || (*cur == '+'))) ? (*cur++ == '-') : false;
+            int exp;
+            if (!parseInt(cur, end, exp)) { return false; }
+            value *= pow(10.0, negativeExp ? -exp : exp);
+        }
+        if (negative) { value = -value; }
+        return true;
+    }
+
+    // the word ends at a whitespace or colon. the following colon is consumed.
+    bool nextWord(const char *&word, size_t &len) {
+        cur = skipSpace(cur, end);
+        for (word = cur; (cur != end) && !isSpace(*cur) && (*cur != ':'); ++cur) {}
+        len = cur - word;
+        while ((cur != end) && ((*cur == ' ') || (*cur == '\t'))) { ++cur; }
+        if ((cur != end) && (*cur == ':')) { ++cur; }
+        return (len > 0);
+    }
+
+    // the rest of the current line without the surrounding whitespaces.
+    String restOfLine() {
+        const char *begin = skipSpace(cur, end);
+        if (find(cur, begin, '\n') != begin) { return String(); } // it is already at the next line.
+        cur = find(begin, end, '\n');
+        const char *last = cur;
+        while ((last != begin) && isSpace(*(last - 1))) { --last; }
+        return String(begin, last);
+    }
+
+protected:
+    static bool isDigit(char c) { return (c >= '0') && (c <= '9'); }
+    static bool isSpace(char c) { return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t'); }
+
+    const char *cur;
+    const char *end;
+};
+
+bool toTsplibMetric(const String &type, Problem::Metric &metric) {
+    static const Map<String, Problem::Metric> metrics({
+        { "EXPLICIT", Problem::Metric::Explicit },
+        { "EUC_2D", Problem::Metric::Euc2d },
+        { "CEIL_2D", Problem::Metric::Ceil2d },
+        { "ATT", Problem::Metric::Att },
+        { "GEO", Problem::Metric::Geo },
+        { "MAN_2D", Problem::Metric::Man2d },
+        { "MAX_2D", Problem::Metric::Max2d }
+    });
+    auto m = metrics.find(type);
+    if (m == metrics.end()) { return false; }
+    metric = m->second;
+    return true;
+}
+
+}
+
+
+bool Problem::Input::load(const String &path) {
+    if (hasExtension(path, FileExtension::binary())) { return InstanceReader::loadBinary(path, *this); }
+    if (hasExtension(path, FileExtension::orLibrary())) { return InstanceReader::loadOrLibrary(path, *this); }
+    if (hasExtension(path, FileExtension::tsplib())) { return InstanceReader::loadTsplib(path, *this); }
+    if (InstanceReader::loadJson(path, *this)) { return true; }
+
+    Log(LogSwitch::Szx::Input) << "fall back to protobuf for " << path << "." << endl;
+    if (!pb::load(path, *this)) { return false; }
+    return InstanceReader::fromProtobuf(*this);
+}
+
+
+bool InstanceReader::loadJson(const String &path, Problem::Input &input) {
+    MemoryMappedFile file;
+    if (!file.open(path)) { return false; }
+    return parseJson(file.data(), file.data() + file.size(), input);
+}
+
+bool InstanceReader::parseJson(const char *s, const char *end, Problem::Input &input) {
+    enum EdgeField { Source = 0x1, Target = 0x2, Length = 0x4 };
+
+    List<Problem::Edge> &edges(input.edgeList);
+    edges.clear();
+    ID maxNodeId = 0;
+    int centerNum = 0;
+
+    // every object with edge fields is an edge. the omitted fields are 0 as in proto3.
+    Problem::Edge edge = { 0, 0, 0 };
+    int fields = 0;
+    int depth = 0;
+    while (s != end) {
+        switch (*s) {
+        case '{':
+            ++depth;
+            fields = 0;
+            edge = { 0, 0, 0 };
+            ++s;
+            break;
+        case '}':
+            if (fields != 0) {
+                if ((edge.source <= 0) || (edge.target <= 0) || (edge.length < 0)) { return false; }
+                maxNodeId = (max)(maxNodeId, (max)(edge.source, edge.target));
+                edges.push_back({ edge.source - 1, edge.target - 1, edge.length });
+                fields = 0;
+            }
+            if (--depth < 0) { return false; }
+            ++s;
+            break;
+        case '"': {
+            const char *key = ++s;
+            for (; (s != end) && (*s != '"'); ++s) {
+                if ((*s == '\\') && (++s == end)) { return false; } // skip the escaped character.
+            }
+            if (s == end) { return false; }
+            size_t len = s - key;
+            s = skipSpace(s + 1, end);
+            if ((s == end) || (*s != ':')) { break; } // string value.
+            s = skipSpace(s + 1, end);
+            if (isKey(key, len, "source")) {
+                if (!parseInt(s, end, edge.source)) { return false; }
+                fields |= EdgeField::Source;
+            } else if (isKey(key, len, "target")) {
+                if (!parseInt(s, end, edge.target)) { return false; }
+                fields |= EdgeField::Target;
+            } else if (isKey(key, len, "length")) {
+                if (!parseInt(s, end, edge.length)) { return false; }
+                fields |= EdgeField::Length;
+            } else if (isKey(key, len, "centerNum")) {
+                if (!parseInt(s, end, centerNum)) { return false; }
+            }
+            break;
+        }
+        default:
+            ++s;
+            break;
+        }
+    }
+    if ((depth != 0) || edges.empty()) { return false; }
+
+    input.nodeNum = maxNodeId;
+    input.set_centernum(centerNum);
+    return true;
+}
+
+bool InstanceReader::loadOrLibrary(const String &path, Problem::Input &input) {
+    MemoryMappedFile file;
+    if (!file.open(path)) { return false; }
+    return parseOrLibrary(file.data(), file.data() + file.size(), input);
+}
+
+bool InstanceReader::parseOrLibrary(const char *begin, const char *end, Problem::Input &input) {
+    Tokenizer tokenizer(begin, end);
+    ID nodeNum;
+    int edgeNum;
+    int centerNum;
+    if (!tokenizer.nextInt(nodeNum) || !tokenizer.nextInt(edgeNum) || !tokenizer.nextInt(centerNum)) { return false; }
+    if ((nodeNum <= 0) || (edgeNum <= 0) || (centerNum <= 0)) { return false; }
+
+    List<Problem::Edge> &edges(input.edgeList);
+    edges.resize(edgeNum);
+    for (auto e = edges.begin(); e != edges.end(); ++e) {
+        if (!tokenizer.nextInt(e->source) || !tokenizer.nextInt(e->target) || !tokenizer.nextInt(e->length)) { return false; }
+        if ((e->source <= 0) || (e->source > nodeNum) || (e->target <= 0) || (e->target > nodeNum)) { return false; }
+        if (e->length < 0) { return false; }
+        --e->source;
+        --e->target;
+    }
+
+    input.nodeNum = nodeNum;
+    input.set_centernum(centerNum);
+    return true;
+}
+
+bool InstanceReader::loadTsplib(const String &path, Problem::Input &input) {
+    MemoryMappedFile file;
+    if (!file.open(path)) { return false; }
+    return parseTsplib(file.data(), file.data() + file.size(), input);
+}
+
+bool InstanceReader::parseTsplib(const char *begin, const char *end, Problem::Input &input) {
+    Tokenizer tokenizer(begin, end);
+    ID nodeNum = 0;
+    ID centerNum = 0;
+    bool hasMetric = false;
+    Problem::Metric metric = Problem::Metric::Explicit;
+    String weightFormat;
+    List<double> xs;
+    List<double> ys;
+    List<Length> weights;
+
+    const char *key;
+    size_t len;
+    while (!tokenizer.eof() && tokenizer.nextWord(key, len)) {
+        if (isKey(key, len, "EOF")) {
+            break;
+        } else if (isKey(key, len, "NODE_COORD_SECTION") || isKey(key, len, "DISPLAY_DATA_SECTION")) {
+            if (nodeNum <= 0) { return false; }
+            bool isDisplay = (*key == 'D'); // the display data is skipped.
+            if (!isDisplay) {
+                xs.resize(nodeNum);
+                ys.resize(nodeNum);
+            }
+            for (ID n = 0; n < nodeNum; ++n) {
+                ID id;
+                double x;
+                double y;
+                if (!tokenizer.nextInt(id) || !tokenizer.nextReal(x) || !tokenizer.nextReal(y)) { return false; }
+                if ((id <= 0) || (id > nodeNum)) { return false; }
+                if (isDisplay) { continue; }
+                xs[id - 1] = x;
+                ys[id - 1] = y;
+            }
+        } else if (isKey(key, len, "EDGE_WEIGHT_SECTION")) {
+            if (nodeNum <= 0) { return false; }
+            size_t n = static_cast<size_t>(nodeNum);
+            size_t weightNum = 0;
+            if (weightFormat == "FULL_MATRIX") {
+                weightNum = n * n;
+            } else if ((weightFormat == "UPPER_ROW") || (weightFormat == "LOWER_ROW")
+                || (weightFormat == "UPPER_COL") || (weightFormat == "LOWER_COL")) {
+                weightNum = n * (n - 1) / 2;
+            } else if ((weightFormat == "UPPER_DIAG_ROW") || (weightFormat == "LOWER_DIAG_ROW")
+                || (weightFormat == "UPPER_DIAG_COL") || (weightFormat == "LOWER_DIAG_COL")) {
+                weightNum = n * (n + 1) / 2;
+            } else {
+                return false;
+            }
+            weights.resize(weightNum);
+            for (auto w = weights.begin(); w != weights.end(); ++w) {
+                if (!tokenizer.nextInt(*w) || (*w < 0)) { return false; }
+            }
+        } else if (isKey(key, len, "FIXED_EDGES_SECTION") || isKey(key, len, "TOUR_SECTION")) {
+            return false;
+        } else {
+            String value(tokenizer.restOfLine());
+            if (isKey(key, len, "TYPE")) {
+                if (value.compare(0, 3, "TSP") != 0) { return false; } // the asymmetric ones are not supported.
+            } else if (isKey(key, len, "DIMENSION")) {
+                nodeNum = atoi(value.c_str());
+            } else if (isKey(key, len, "EDGE_WEIGHT_TYPE")) {
+                hasMetric = toTsplibMetric(value, metric);
+            } else if (isKey(key, len, "EDGE_WEIGHT_FORMAT")) {
+                weightFormat = value;
+            } else if (isKey(key, len, "COMMENT")) { // written by saveTsplib().
+                size_t pos = value.find("p=");
+                if (pos != String::npos) { centerNum = atoi(value.c_str() + pos + 2); }
+            }
+        }
+    }
+    if ((nodeNum <= 0) || !hasMetric) { return false; }
+
+    input.edgeList.clear();
+    input.adjOffsets = nullptr;
+    input.adjNodes = nullptr;
+    input.adjLengths = nullptr;
+    input.distMatrix = nullptr;
+    input.storage.reset();
+    if (metric != Problem::Metric::Explicit) { // the distances are computed on demand by the solver.
+        if (xs.empty()) { return false; }
+        input.xCoords.swap(xs);
+        input.yCoords.swap(ys);
+    } else {
+        if (weights.empty()) { return false; }
+        size_t n = static_cast<size_t>(nodeNum);
+        shared_ptr<List<Length>> matrix(make_shared<List<Length>>(n * n, 0));
+        Length *dist = matrix->data();
+        // the lower triangle by rows is the upper triangle by columns and vice versa.
+        bool isFull = (weightFormat == "FULL_MATRIX");
+        bool isUpperRow = (weightFormat.compare(0, 5, "UPPER") == 0) == (weightFormat.find("ROW") != String::npos);
+        bool hasDiag = (weightFormat.find("DIAG") != String::npos);
+        auto w = weights.begin();
+        for (size_t i = 0; i < n; ++i) {
+            size_t first = isFull ? 0 : (isUpperRow ? (hasDiag ? i : (i + 1)) : 0);
+            size_t last = isFull ? n : (isUpperRow ? n : (hasDiag ? (i + 1) : i));
+            for (size_t j = first; j < last; ++j, ++w) {
+                dist[i * n + j] = *w;
+                if (!isFull) { dist[j * n + i] = *w; }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) { dist[i * n + i] = 0; }
+        input.distMatrix = dist;
+        input.storage = matrix;
+    }
+
+    input.nodeNum = nodeNum;
+    input.set_centernum(centerNum);
+    input.metric = metric;
+    return true;
+}
+
+bool InstanceReader::fromProtobuf(Problem::Input &input) {
+    List<Problem::Edge> &edges(input.edgeList);
+    edges.clear();
+    edges.reserve(input.graph().edges().size());
+    ID maxNodeId = 0;
+    for (auto e = input.graph().edges().begin(); e != input.graph().edges().end(); ++e) {
+        if ((e->source() <= 0) || (e->target() <= 0) || (e->length() < 0)) { return false; }
+        maxNodeId = (max)(maxNodeId, (max)(e->source(), e->target()));
+        edges.push_back({ e->source() - 1, e->target() - 1, e->length() });
+    }
+    input.nodeNum = maxNodeId;
+    input.mutable_graph()->Clear();
+    return !edges.empty();
+}
+
+bool InstanceReader::loadBinary(const String &path, Problem::Input &input) {
+    shared_ptr<MemoryMappedFile> file(make_shared<MemoryMappedFile>());
+    if (!file->open(path) || (file->size() < sizeof(BinaryHeader))) { return false; }
+
+    BinaryHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (memcmp(header.magic, BinaryMagic, sizeof(header.magic)) != 0) { return false; }
+    if ((header.nodeNum <= 0) || (header.edgeNum < 0) || (header.centerNum <= 0)) { return false; }
+
+    size_t nodeNum = static_cast<size_t>(header.nodeNum);
+    size_t arcNum = 2 * static_cast<size_t>(header.edgeNum);
+    const char *body = file->data() + sizeof(header);
+    if (header.layout == BinaryLayout::Csr) {
+        if (file->size() != sizeof(header) + (nodeNum + 1 + arcNum) * sizeof(ID) + arcNum * sizeof(Length)) { return false; }
+        const ID *offsets = reinterpret_cast<const ID*>(body);
+        const ID *nodes = offsets + nodeNum + 1;
+        const Length *lengths = reinterpret_cast<const Length*>(nodes + arcNum);
+        // the graph is indexed without checking later, so a corrupt file must be rejected here in O(n + m).
+        if ((offsets[0] != 0) || (static_cast<size_t>(offsets[nodeNum]) != arcNum)) { return false; }
+        for (size_t n = 0; n < nodeNum; ++n) {
+            if (offsets[n] > offsets[n + 1]) { return false; }
+        }
+        for (size_t a = 0; a < arcNum; ++a) {
+            if ((nodes[a] < 0) || (nodes[a] >= header.nodeNum) || (lengths[a] < 0)) { return false; }
+        }
+        input.adjOffsets = offsets;
+        input.adjNodes = nodes;
+        input.adjLengths = lengths;
+        input.distMatrix = nullptr;
+    } else if (header.layout == BinaryLayout::DistMatrix) {
+        if (file->size() != sizeof(header) + nodeNum * nodeNum * sizeof(Length)) { return false; }
+        // the lengths are used without checking as well. they can not exceed INF, which is the max Length.
+        const Length *dist = reinterpret_cast<const Length*>(body);
+        if (any_of(dist, dist + nodeNum * nodeNum, [](Length d) { return d < 0; })) { return false; }
+        input.adjOffsets = nullptr;
+        input.adjNodes = nullptr;
+        input.adjLengths = nullptr;
+        input.distMatrix = dist;
+    } else if (header.layout == BinaryLayout::Coordinates) {
+        // the coordinates are copied since the distance oracle owns them.
+        if (file->size() != sizeof(header) + sizeof(int) + 2 * nodeNum * sizeof(double)) { return false; }
+        int metric;
+        memcpy(&metric, body, sizeof(metric));
+        if ((metric <= Problem::Metric::Explicit) || (metric > Problem::Metric::Max2d)) { return false; }
+        input.metric = static_cast<Problem::Metric>(metric);
+        input.xCoords.resize(nodeNum);
+        input.yCoords.resize(nodeNum);
+        memcpy(input.xCoords.data(), body + sizeof(metric), nodeNum * sizeof(double));
+        memcpy(input.yCoords.data(), body + sizeof(metric) + nodeNum * sizeof(double), nodeNum * sizeof(double));
+        input.adjOffsets = nullptr;
+        input.adjNodes = nullptr;
+        input.adjLengths = nullptr;
+        input.distMatrix = nullptr;
+        file.reset();
+    } else {
+        return false;
+    }
+
+    input.nodeNum = header.nodeNum;
+    input.set_centernum(header.centerNum);
+    input.edgeList.clear();
+    input.storage = file;
+    return true;
+}
+
+bool InstanceReader::saveBinary(const String &path, const Problem::Input &input, const List<List<Length>> *dist) {
+    bool hasCoords = (input.metric != Problem::Metric::Explicit);
+    if (!dist && !hasCoords && input.edgeList.empty()) { return false; }
+    ofstream ofs(path, ios::binary);
+    if (!ofs.is_open()) { return false; }
+
+    BinaryHeader header;
+    memcpy(header.magic, BinaryMagic, sizeof(header.magic));
+    header.nodeNum = input.nodeNum;
+    header.edgeNum = static_cast<ID>(input.edgeList.size());
+    header.centerNum = input.centernum();
+    header.layout = dist ? BinaryLayout::DistMatrix : (hasCoords ? BinaryLayout::Coordinates : BinaryLayout::Csr);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (dist) {
+        for (auto row = dist->begin(); row != dist->end(); ++row) {
+            ofs.write(reinterpret_cast<const char*>(row->data()), row->size() * sizeof(Length));
+        }
+        return static_cast<bool>(ofs);
+    }
+    if (hasCoords) {
+        int metric = input.metric;
+        ofs.write(reinterpret_cast<const char*>(&metric), sizeof(metric));
+        ofs.write(reinterpret_cast<const char*>(input.xCoords.data()), input.xCoords.size() * sizeof(double));
+        ofs.write(reinterpret_cast<const char*>(input.yCoords.data()), input.yCoords.size() * sizeof(double));
+        return static_cast<bool>(ofs);
+    }
+
+    // counting sort the arcs by their tails so that the edge order is kept in each adjacency list.
+    List<ID> offsets(input.nodeNum + 1, 0);
+    for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+        ++offsets[e->source + 1];
+        ++offsets[e->target + 1];
+    }
+    for (ID n = 0; n < input.nodeNum; ++n) { offsets[n + 1] += offsets[n]; }
+    List<ID> nodes(offsets.back());
+    List<Length> lengths(offsets.back());
+    List<ID> next(offsets.begin(), offsets.end() - 1);
+    for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+        nodes[next[e->source]] = e->target;
+        lengths[next[e->source]++] = e->length;
+        nodes[next[e->target]] = e->source;
+        lengths[next[e->target]++] = e->length;
+    }
+    ofs.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(ID));
+    ofs.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(ID));
+    ofs.write(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(Length));
+    return static_cast<bool>(ofs);
+}
+
+bool InstanceReader::saveJson(const String &path, const Problem::Input &input) {
+    ofstream ofs(path);
+    if (!ofs.is_open()) { return false; }
+
+    // the same layout as pb::protobufToJson().
+    ofs << "{\n \"graph\": {\n  \"edges\": [";
+    for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+        ofs << ((e == input.edgeList.begin()) ? "\n" : ",\n")
+            << "   {\n    \"source\": " << (e->source + 1)
+            << ",\n    \"target\": " << (e->target + 1)
+            << ",\n    \"length\": " << e->length << "\n   }";
+    }
+    ofs << "\n  ]\n },\n \"centerNum\": " << input.centernum() << "\n}";
+    return static_cast<bool>(ofs);
+}
+
+bool InstanceReader::saveTsplib(const String &path, const Problem::Input &input, const String &name) {
+    static const Map<Problem::Metric, String> metricNames({
+        { Problem::Metric::Euc2d, "EUC_2D" },
+        { Problem::Metric::Ceil2d, "CEIL_2D" },
+        { Problem::Metric::Att, "ATT" },
+        { Problem::Metric::Geo, "GEO" },
+        { Problem::Metric::Man2d, "MAN_2D" },
+        { Problem::Metric::Max2d, "MAX_2D" }
+    });
+    auto metric = metricNames.find(input.metric);
+    if (metric == metricNames.end()) { return false; }
+    ofstream ofs(path);
+    if (!ofs.is_open()) { return false; }
+
+    ofs << "NAME : " << name << "\n"
+        << "COMMENT : p=" << input.centernum() << "\n"
+        << "TYPE : TSP\n"
+        << "DIMENSION : " << input.nodeNum << "\n"
+        << "EDGE_WEIGHT_TYPE : " << metric->second << "\n"
+        << "NODE_COORD_SECTION\n";
+    ofs.precision(12);
+    for (ID n = 0; n < input.nodeNum; ++n) {
+        ofs << (n + 1) << " " << input.xCoords[n] << " " << input.yCoords[n] << "\n";
+    }
+    ofs << "EOF\n";
+    return static_cast<bool>(ofs);
+}
+
+}
@@ -0,0 +1,74 @@
+////////////////////////////////
+/// usage : 1.	load instances into the compact graph representation without protobuf reflection.
+///         2.	the format is decided by the file extension, i.e., .bin, .txt (OR-Library), .tsp (TSPLIB) or JSON.
+///
+/// note  : 1.	Problem::Input::load() tries these readers first and falls back to pb::load().
+///         2.	the binary instance is a BinaryHeader followed by the arrays of the layout in native byte order.
+///             Csr: ID offsets[nodeNum + 1], ID nodes[2 * edgeNum], Length lengths[2 * edgeNum].
+///             DistMatrix: Length dist[nodeNum * nodeNum].
+///             Coordinates: int metric, double x[nodeNum], double y[nodeNum].
+////////////////////////////////
+
+#ifndef SMART_JQ_PCENTER_INSTANCE_READER_H
+#define SMART_JQ_PCENTER_INSTANCE_READER_H
+
+
+#include "Config.h"
+
+#include <string>
+#include "Common.h"
+#include "Problem.h"
+
+
+namespace szx {
+
+class InstanceReader {
+public:
+    enum BinaryLayout { Csr = 0, DistMatrix = 1, Coordinates = 2 };
+
+    struct BinaryHeader {
+        char magic[4];
+        ID nodeNum;
+        ID edgeNum; // number of undirected edges in the original graph.
+        ID centerNum;
+        int layout; // BinaryLayout.
+    };
+
+
+    static constexpr char BinaryMagic[] = "PCI1";
+
+
+    // streaming parser for the JSON of pb::PCenter::Input.
+    static bool loadJson(const String &path, Problem::Input &input);
+    static bool parseJson(const char *begin, const char *end, Problem::Input &input);
+
+    // OR-Library pmed instances, i.e., "n m p" followed by m lines of "i j cost" with one-based node IDs.
+    // the last one is kept if an edge appears more than once.
+    static bool loadOrLibrary(const String &path, Problem::Input &input);
+    static bool parseOrLibrary(const char *begin, const char *end, Problem::Input &input);
+
+    // symmetric TSPLIB instances with explicit weights or 2D coordinates. the distances are used as they are,
+    // and the coordinates are kept for the distance oracle. the number of centers is read from "p=N" in the comment
+    // (as written by saveTsplib()) or left 0.
+    static bool loadTsplib(const String &path, Problem::Input &input);
+    static bool parseTsplib(const char *begin, const char *end, Problem::Input &input);
+
+    // fill the compact edge list with the repeated edge messages and release them.
+    // return false if there is no edge, or a node ID is not positive or a length is negative.
+    static bool fromProtobuf(Problem::Input &input);
+
+    // map the binary instance into memory and point the input views to it without copying.
+    static bool loadBinary(const String &path, Problem::Input &input);
+    // convert the input loaded from other formats. the graph or coordinates are stored if dist is null.
+    static bool saveBinary(const String &path, const Problem::Input &input, const List<List<Length>> *dist = nullptr);
+
+    // write the graph in the JSON of pb::PCenter::Input without building the protobuf messages.
+    static bool saveJson(const String &path, const Problem::Input &input);
+    // write the coordinates in TSPLIB format. the number of centers is kept in the comment.
+    static bool saveTsplib(const String &path, const Problem::Input &input, const String &name);
+};
+
+}
+
+
+#endif // SMART_JQ_PCENTER_INSTANCE_READER_H
@@ -35,9 +35,9 @@ std::string protobufToJson(const T &obj, bool pretty = true) {
 }
 
 template<typename T>
-void jsonToProtobuf(const std::string &data, T &obj) {
+bool jsonToProtobuf(const std::string &data, T &obj) {
     google::protobuf::util::JsonParseOptions options;
-    google::protobuf::util::JsonStringToMessage(data, &obj, options);
+    return google::protobuf::util::JsonStringToMessage(data, &obj, options).ok();
 }
 
 template<typename T>
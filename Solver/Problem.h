@@ -12,9 +12,11 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <vector>
 #include "Common.h"
+#include "Utility.h"
 #include "PbReader.h"
 #include "PCenter.pb.h"
 
@@ -24,13 +26,53 @@ namespace szx {
 class Problem {
     #pragma region Type
 public:
+    // distance functions of TSPLIB (Reinelt, 1995). the explicit distances are given by a graph or matrix.
+    enum Metric { Explicit, Euc2d, Ceil2d, Att, Geo, Man2d, Max2d };
+
+    struct Edge {
+        ID source; // zero-based node ID.
+        ID target; // zero-based node ID.
+        Length length;
+    };
+
     struct Input : public pb::PCenter::Input {
-        bool load(const String &path) { return pb::load(path, *this); }
+        // the repeated edge messages are empty after loading. use the compact edge list instead.
+        bool load(const String &path); // defined in InstanceReader.cpp.
+
+        ID nodeNum = 0;
+        List<Edge> edgeList; // empty if the instance is loaded from a binary file.
+
+        // views into the binary instance or the matrix of the TSPLIB instance.
+        // at most one of the graph and the matrix is available.
+        const ID *adjOffsets = nullptr; // the adjacent nodes of node i are in [adjOffsets[i], adjOffsets[i + 1]).
+        const ID *adjNodes = nullptr;
+        const Length *adjLengths = nullptr;
+        const Length *distMatrix = nullptr; // row-major shortest path lengths between all nodes.
+        std::shared_ptr<const void> storage; // keep the views valid.
+
+        // coordinates of the nodes if the distances are computed by the metric on demand.
+        Metric metric = Metric::Explicit;
+        List<double> xCoords;
+        List<double> yCoords;
     };
 
     struct Output : public pb::PCenter::Output {
+        // load the solution saved by save(), i.e., skip the submission information in the first line.
+        bool load(const String &path) {
+            std::ifstream ifs(path);
+            if (!ifs.is_open()) { return false; }
+
+            String submission;
+            std::getline(ifs, submission);
+            std::ostringstream oss;
+            oss << ifs.rdbuf();
+            return pb::jsonToProtobuf(oss.str(), *this);
+        }
+
+        // the file is written to a temporary path and then renamed, so it is either the old or the new solution.
         bool save(const String &path, pb::PCenter_Submission &submission) const {
-            std::ofstream ofs(path);
+            String tmpPath(path + ".tmp");
+            std::ofstream ofs(tmpPath);
             if (!ofs.is_open()) { return false; }
 
             // TODO[0]: fill the submission information.
@@ -44,7 +86,9 @@ public:
             submission.set_problem("PCenter");
 
             ofs << pb::protobufToJson(submission, false) << std::endl << pb::protobufToJson(*this);
-            return true;
+            ofs.close();
+            if (!ofs) { return false; }
+            return System::moveFile(tmpPath, path);
         }
 
         int maxLength = 0;
@@ -1,14 +1,21 @@
 #include "Solver.h"
 #include <algorithm>
+#include <iterator>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include <cmath>
+#include <csignal>
+#include <queue>
+#include <unordered_map>
 #include<map>
+#include "CsvReader.h"
+#include "Daemon.h"
 #include "../Checker/CheckConstraints.h"
 
 
@@ -16,7 +23,16 @@ using namespace std;
 
 namespace szx {
 
+namespace {
+void onInterrupt(int sig) {
+    Solver::Cli::interruption.cancel();
+    signal(sig, SIG_DFL); // the next one terminates the process at once.
+}
+}
+
 #pragma region Solver::Cli
+CancellationToken Solver::Cli::interruption;
+
 int Solver::Cli::run(int argc, char * argv[]) {
     Log(LogSwitch::Szx::Cli) << "parse command line arguments." << endl;
     Set<String> switchSet;
@@ -30,7 +46,17 @@ int Solver::Cli::run(int argc, char * argv[]) {
         { RunIdOption(), nullptr },
         { EnvironmentPathOption(), nullptr },
         { ConfigPathOption(), nullptr },
-        { LogPathOption(), nullptr }
+        { LogPathOption(), nullptr },
+        { CheckpointPathOption(), nullptr },
+        { ResumePathOption(), nullptr },
+        { InitSolutionPathOption(), nullptr },
+        { TargetOption(), nullptr },
+        { CenterNumOption(), nullptr },
+        { ProgressPathOption(), nullptr },
+        { BatchPathOption(), nullptr },
+        { SummaryPathOption(), nullptr },
+        { DaemonPathOption(), nullptr },
+        { CenterRangeOption(), nullptr }
     });
 
     for (int i = 1; i < argc; ++i) { // skip executable name.
@@ -53,6 +79,23 @@ int Solver::Cli::run(int argc, char * argv[]) {
 
     Solver::Environment env;
     env.load(optionMap);
+    env.progressCenters = (switchSet.find(ProgressCentersSwitch()) != switchSet.end());
+
+    if (optionMap.at(DaemonPathOption()) != nullptr) {
+        Solver::Configuration cfg;
+        cfg.load(env.cfgPath);
+        Daemon daemon(cfg);
+        return daemon.run(optionMap.at(DaemonPathOption())) ? 0 : -1;
+    }
+
+    signal(SIGINT, onInterrupt);
+    signal(SIGTERM, onInterrupt);
+    if (optionMap.at(BatchPathOption()) != nullptr) {
+        Solver::Configuration cfg;
+        cfg.load(env.cfgPath);
+        char *summaryPath = optionMap.at(SummaryPathOption());
+        return runBatch(optionMap.at(BatchPathOption()), summaryPath ? summaryPath : Environment::DefaultSummaryPath(), env, cfg);
+    }
     if (env.instPath.empty() || env.slnPath.empty()) { return -1; }
 
     Solver::Configuration cfg;
@@ -61,9 +104,24 @@ int Solver::Cli::run(int argc, char * argv[]) {
     Log(LogSwitch::Szx::Input) << "load instance " << env.instPath << " (seed=" << env.randSeed << ")." << endl;
     Problem::Input input;
     if (!input.load(env.instPath)) { return -1; }
+    if (optionMap.at(CenterRangeOption()) != nullptr) { return runSweep(input, optionMap.at(CenterRangeOption()), env, cfg); }
+    if (env.centerNum > 0) { input.set_centernum(env.centerNum); }
+    if (input.centernum() <= 0) {
+        Log(LogSwitch::Szx::Input) << "the number of centers is not given." << endl;
+        return -1;
+    }
+
+    solve(input, env, cfg);
+    return 0;
+}
 
+Length Solver::Cli::solve(const Problem::Input &input, const Environment &env, const Configuration &cfg,
+    shared_ptr<const DistanceTable> table) {
     Solver solver(input, env, cfg);
-    solver.solve();
+    solver.aux.table = table;
+    solver.cancellation.link(&interruption);
+    bool success = solver.solve();
+    if (interruption.isCancelled()) { Log(LogSwitch::Szx::Framework) << "interrupted. save the best solution." << endl; }
 
     pb::PCenter_Submission submission;
     submission.set_thread(to_string(env.jobNum));
@@ -76,7 +134,176 @@ int Solver::Cli::run(int argc, char * argv[]) {
     solver.record();
     #endif // JQ_DEBUG
 
-    return 0;
+    return success ? solver.output.maxLength : -1;
+}
+
+int Solver::Cli::runBatch(const String &manifestPath, const String &summaryPath, const Environment &env, const Configuration &cfg) {
+    struct Job {
+        Environment env;
+        String timeout; // in seconds. it is empty if not given.
+        long long fileSize; // estimate the solving time without loading.
+        Length obj;
+        double duration; // in seconds.
+    };
+    struct CachedInput {
+        once_flag loadFlag;
+        bool isLoaded = false;
+        Problem::Input input;
+        shared_ptr<const DistanceTable> table;
+        int jobNum = 0; // number of unfinished jobs on it. it is released once all jobs are done.
+    };
+
+    ifstream ifs(manifestPath);
+    if (!ifs.is_open()) {
+        Log(LogSwitch::Szx::Input) << "fail to open the manifest " << manifestPath << endl;
+        return -1;
+    }
+    CsvReader cr;
+    const List<CsvReader::Row> &rows(cr.scan(ifs));
+
+    List<Job> jobs;
+    Map<String, shared_ptr<CachedInput>> inputs;
+    for (auto row = rows.begin(); row != rows.end(); ++row) {
+        if ((*row)[0][0] == '#') { continue; } // comment.
+        if (row->size() < 4) {
+            Log(LogSwitch::Szx::Input) << "skip the incomplete job " << (*row)[0] << endl;
+            continue;
+        }
+        const CsvReader::Row &cells(*row);
+        Environment jobEnv(cells[0], cells[3], (*cells[1] ? atoi(cells[1]) : Random::generateSeed()),
+            (*cells[2] ? atof(cells[2]) : Environment::DefaultTimeout), env.maxIter, 1,
+            to_string(jobs.size()), env.cfgPath, env.logPath);
+        jobEnv.centerNum = ((cells.size() > 4) && *cells[4]) ? atoi(cells[4]) : env.centerNum;
+        jobEnv.target = env.target;
+        jobEnv.calibrate();
+
+        shared_ptr<CachedInput> &cachedInput(inputs[jobEnv.instPath]);
+        if (!cachedInput) { cachedInput = make_shared<CachedInput>(); }
+        ++cachedInput->jobNum;
+
+        ifstream inst(jobEnv.instPath, ios::binary | ios::ate);
+        jobs.push_back({ jobEnv, cells[2], inst.is_open() ? static_cast<long long>(inst.tellg()) : 0, -1, 0 });
+    }
+
+    // longest processing time first.
+    List<int> order(jobs.size());
+    for (int j = 0; j < static_cast<int>(jobs.size()); ++j) { order[j] = j; }
+    stable_sort(order.begin(), order.end(), [&](int l, int r) { return jobs[l].fileSize > jobs[r].fileSize; });
+
+    atomic<int> nextJob(0);
+    mutex inputMutex;
+    auto work = [&]() {
+        for (int j; (j = nextJob.fetch_add(1)) < static_cast<int>(order.size());) {
+            if (interruption.isCancelled()) { break; } // the rest are reported as failed.
+            Job &job(jobs[order[j]]);
+            shared_ptr<CachedInput> cachedInput;
+            {
+                lock_guard<mutex> inputGuard(inputMutex);
+                cachedInput = inputs[job.env.instPath];
+            }
+            call_once(cachedInput->loadFlag, [&]() {
+                Log(LogSwitch::Szx::Input) << "load instance " << job.env.instPath << endl;
+                cachedInput->isLoaded = cachedInput->input.load(job.env.instPath);
+                if (!cachedInput->isLoaded) { return; }
+                shared_ptr<DistanceTable> table(make_shared<DistanceTable>());
+                buildDistanceTable(cachedInput->input, cfg, 1, *table);
+                cachedInput->table = table;
+            });
+
+            Timer::TimePoint begin = Timer::Clock::now();
+            ID centerNum = (job.env.centerNum > 0) ? job.env.centerNum : cachedInput->input.centernum();
+            if (cachedInput->isLoaded && (centerNum > 0)) { job.obj = solve(cachedInput->input, job.env, cfg, cachedInput->table); }
+            job.duration = chrono::duration<double>(Timer::Clock::now() - begin).count();
+            Log(LogSwitch::Szx::Framework) << "job " << job.env.rid << " on " << job.env.instPath << " got " << job.obj << endl;
+
+            lock_guard<mutex> inputGuard(inputMutex);
+            if (--cachedInput->jobNum <= 0) { inputs.erase(job.env.instPath); }
+        }
+    };
+    int threadNum = (min)(env.jobNum, static_cast<int>(jobs.size()));
+    List<thread> threadList;
+    threadList.reserve(threadNum);
+    for (int i = 0; i < threadNum; ++i) { threadList.emplace_back(work); }
+    for (auto t = threadList.begin(); t != threadList.end(); ++t) { t->join(); }
+
+    ofstream summary(summaryPath);
+    if (!summary.is_open()) { return -1; }
+    summary << "Instance,Seed,Timeout,Solution,Obj,Duration" << endl;
+    int failedNum = 0;
+    for (auto job = jobs.begin(); job != jobs.end(); ++job) {
+        if (job->obj < 0) { ++failedNum; }
+        summary << job->env.instPath << "," << job->env.randSeed << "," << job->timeout << ","
+            << job->env.slnPath << "," << job->obj << "," << job->duration << endl;
+    }
+    return failedNum;
+}
+int Solver::Cli::runSweep(const Problem::Input &input, const String &range, const Environment &env, const Configuration &cfg) {
+    size_t colon = range.find(':');
+    int first = atoi(range.c_str());
+    int last = (colon == String::npos) ? first : atoi(range.c_str() + colon + 1);
+    if ((first <= 0) || (first > last) || (last > input.nodeNum)) {
+        Log(LogSwitch::Szx::Input) << "invalid range of the number of centers " << range << endl;
+        return -1;
+    }
+
+    Log(LogSwitch::Szx::Preprocess) << "build the distance table for p in [" << first << ", " << last << "]." << endl;
+    shared_ptr<DistanceTable> table(make_shared<DistanceTable>());
+    buildDistanceTable(input, cfg, env.jobNum, *table);
+
+    // the search effort grows with p, so the chunks get about the same sum of p.
+    int num = last - first + 1;
+    int threadNum = (min)(env.jobNum, num);
+    List<int> chunkBegins(threadNum + 1, last + 1);
+    long long totalWork = 0;
+    for (int p = first; p <= last; ++p) { totalWork += p; }
+    long long work = 0;
+    for (int p = first, t = 0; p <= last; work += p++) {
+        if (work * threadNum >= totalWork * t) { chunkBegins[t++] = p; }
+    }
+
+    List<List<ID>> centers(num); // one-based node IDs.
+    List<Length> radii(num, -1);
+    List<double> durations(num, 0);
+    auto sweep = [&](int t) {
+        List<ID> prevCenters;
+        for (int p = chunkBegins[t]; p < chunkBegins[t + 1]; ++p) {
+            if (interruption.isCancelled()) { break; }
+            Environment subEnv(env);
+            subEnv.slnPath.clear();
+            subEnv.progressPath.clear();
+            subEnv.jobNum = 1;
+            subEnv.centerNum = p;
+            Solver solver(input, subEnv, cfg);
+            solver.aux.table = table;
+            solver.initCenters.swap(prevCenters);
+            solver.cancellation.link(&interruption);
+            bool success = solver.solve();
+
+            int i = p - first;
+            durations[i] = solver.timer.elapsedSeconds();
+            if (!success) { continue; }
+            radii[i] = solver.output.maxLength;
+            centers[i].assign(solver.output.centers().begin(), solver.output.centers().end());
+            for (auto c = centers[i].begin(); c != centers[i].end(); ++c) { prevCenters.push_back(*c - 1); }
+            Log(LogSwitch::Szx::Framework) << "p=" << p << " got " << radii[i] << endl;
+        }
+    };
+    List<thread> threadList;
+    threadList.reserve(threadNum);
+    for (int t = 0; t < threadNum; ++t) { threadList.emplace_back(sweep, t); }
+    for (auto th = threadList.begin(); th != threadList.end(); ++th) { th->join(); }
+
+    ofstream curve(env.slnPath);
+    if (!curve.is_open()) { return -1; }
+    curve << "P,Radius,Duration,Centers" << endl;
+    int failedNum = 0;
+    for (int i = 0; i < num; ++i) {
+        if (radii[i] < 0) { ++failedNum; }
+        curve << (first + i) << "," << radii[i] << "," << durations[i] << ",";
+        for (auto c = centers[i].begin(); c != centers[i].end(); ++c) { curve << ((c == centers[i].begin()) ? "" : " ") << *c; }
+        curve << endl;
+    }
+    return failedNum;
 }
 #pragma endregion Solver::Cli
 
@@ -97,7 +324,7 @@ void Solver::Environment::load(const Map<String, char*> &optionMap) {
     if (str != nullptr) { randSeed = atoi(str); }
 
     str = optionMap.at(Cli::TimeoutOption());
-    if (str != nullptr) { msTimeout = static_cast<Duration>(atof(str) * Timer::MillisecondsPerSecond); }
+    if (str != nullptr) { msTimeout = toMilliseconds(atof(str)); }
 
     str = optionMap.at(Cli::MaxIterOption());
     if (str != nullptr) { maxIter = atoi(str); }
@@ -114,6 +341,24 @@ void Solver::Environment::load(const Map<String, char*> &optionMap) {
     str = optionMap.at(Cli::LogPathOption());
     if (str != nullptr) { logPath = str; }
 
+    str = optionMap.at(Cli::CheckpointPathOption());
+    if (str != nullptr) { ckptPath = str; }
+
+    str = optionMap.at(Cli::ResumePathOption());
+    if (str != nullptr) { rsmPath = str; }
+
+    str = optionMap.at(Cli::InitSolutionPathOption());
+    if (str != nullptr) { initPath = str; }
+
+    str = optionMap.at(Cli::TargetOption());
+    if (str != nullptr) { target = atoi(str); }
+
+    str = optionMap.at(Cli::CenterNumOption());
+    if (str != nullptr) { centerNum = atoi(str); }
+
+    str = optionMap.at(Cli::ProgressPathOption());
+    if (str != nullptr) { progressPath = str; }
+
     calibrate();
 }
 
@@ -134,9 +379,6 @@ void Solver::Environment::calibrate() {
     // adjust thread number.
     int threadNum = thread::hardware_concurrency();
     if ((jobNum <= 0) || (jobNum > threadNum)) { jobNum = threadNum; }
-
-    // adjust timeout.
-    msTimeout -= Environment::SaveSolutionTimeInMillisecond;
 }
 #pragma endregion Solver::Environment
 
@@ -151,15 +393,205 @@ void Solver::Configuration::save(const String &filePath) const {
 }
 #pragma endregion Solver::Configuration
 
+#pragma region Solver::SolutionWriter
+void Solver::SolutionWriter::start() {
+    stop();
+    isStopped = false;
+    writer = thread([this]() { run(); });
+}
+
+void Solver::SolutionWriter::stop() {
+    {
+        lock_guard<mutex> snapshotGuard(snapshotMutex);
+        isStopped = true;
+    }
+    snapshotCond.notify_one();
+    if (writer.joinable()) { writer.join(); }
+}
+
+void Solver::SolutionWriter::offer(Length maxLength, const List<ID> &centers) {
+    Length best = bestMaxLength.load(memory_order_relaxed);
+    do {
+        if (maxLength >= best) { return; }
+    } while (!bestMaxLength.compare_exchange_weak(best, maxLength, memory_order_relaxed));
+
+    {
+        lock_guard<mutex> snapshotGuard(snapshotMutex);
+        if (maxLength >= pendingMaxLength) { return; } // a better one is taken by another worker in between.
+        pendingMaxLength = maxLength;
+        pendingCenters = centers;
+        hasPending = true;
+    }
+    snapshotCond.notify_one();
+}
+
+void Solver::SolutionWriter::run() {
+    Timer::TimePoint writeTime = Timer::Clock::now();
+    List<ID> centers;
+    unique_lock<mutex> snapshotLock(snapshotMutex);
+    for (;;) {
+        snapshotCond.wait(snapshotLock, [this]() { return hasPending || isStopped; });
+        // rate limit the writes. the snapshot may be replaced by better ones while waiting.
+        snapshotCond.wait_until(snapshotLock, writeTime, [this]() { return isStopped; });
+        if (isStopped) { return; }
+
+        Length maxLength = pendingMaxLength;
+        centers.swap(pendingCenters);
+        hasPending = false;
+        snapshotLock.unlock();
+        if (!write(maxLength, centers)) {
+            Log(LogSwitch::Szx::Output) << "fail to write the best solution to " << solver.env.slnPath << endl;
+        }
+        writeTime = Timer::Clock::now() + Timer::Millisecond(solver.cfg.msSolutionSaveInterval);
+        snapshotLock.lock();
+    }
+}
+
+bool Solver::SolutionWriter::write(Length maxLength, const List<ID> &centers) const {
+    Problem::Output output;
+    for (auto c = centers.begin(); c != centers.end(); ++c) { output.add_centers(*c + 1); }
+    output.maxLength = maxLength;
+
+    pb::PCenter_Submission submission;
+    submission.set_thread(to_string(solver.env.jobNum));
+    submission.set_instance(solver.env.friendlyInstName());
+    submission.set_duration(to_string(solver.timer.elapsedSeconds()) + "s");
+    return output.save(solver.env.slnPath, submission);
+}
+#pragma endregion Solver::SolutionWriter
+
+#pragma region Solver::ProgressStream
+void Solver::ProgressStream::start(int workerNum) {
+    stop();
+    if (sink) {
+        os = nullptr;
+    } else if (solver.env.progressPath.empty()) {
+        return;
+    } else if (solver.env.progressPath == "-") {
+        os = &cout;
+    } else {
+        ofs.open(solver.env.progressPath);
+        if (!ofs.is_open()) {
+            Log(LogSwitch::Szx::Output) << "fail to open the progress stream " << solver.env.progressPath << endl;
+            return;
+        }
+        os = &ofs;
+    }
+
+    channels = List<Channel>(workerNum);
+    bestMaxLength = INT32_MAX;
+    lastIteration = 0;
+    lastTime = solver.timer.elapsedSeconds();
+    isStopped = false;
+    emitter = thread([this]() { run(); });
+}
+
+void Solver::ProgressStream::stop() {
+    {
+        lock_guard<mutex> stopGuard(stopMutex);
+        isStopped = true;
+    }
+    stopCond.notify_one();
+    if (emitter.joinable()) { emitter.join(); }
+    if (ofs.is_open()) { ofs.close(); }
+}
+
+void Solver::ProgressStream::improve(ID workerId, Iteration iteration, Length maxLength, const List<ID> &centers) {
+    if (channels.empty()) { return; }
+    Channel &channel(channels[workerId]);
+    Event e = { solver.timer.elapsedSeconds(), workerId, iteration, maxLength, List<ID>() };
+    if (solver.env.progressCenters) { e.centers = centers; }
+    if (!channel.events.push(move(e))) { channel.dropNum.fetch_add(1, memory_order_relaxed); }
+}
+
+void Solver::ProgressStream::run() {
+    Timer::TimePoint heartbeatTime = Timer::Clock::now() + Timer::Millisecond(solver.cfg.msProgressInterval);
+    unique_lock<mutex> stopLock(stopMutex);
+    while (!stopCond.wait_for(stopLock, Timer::Millisecond(PollIntervalInMillisecond), [this]() { return isStopped; })) {
+        drain();
+        if (Timer::Clock::now() >= heartbeatTime) {
+            heartbeat("heartbeat");
+            heartbeatTime += Timer::Millisecond(solver.cfg.msProgressInterval);
+        }
+    }
+    drain();
+    heartbeat("end");
+}
+
+void Solver::ProgressStream::drain() {
+    Event e;
+    for (auto c = channels.begin(); c != channels.end(); ++c) {
+        while (c->events.pop(e)) { events.push_back(move(e)); }
+    }
+    if (events.empty()) { return; }
+
+    // the queues are ordered by time individually, but not among the workers.
+    stable_sort(events.begin(), events.end(), [](const Event &l, const Event &r) { return l.time < r.time; });
+    for (auto e = events.begin(); e != events.end(); ++e) {
+        if (e->maxLength >= bestMaxLength) { continue; }
+        bestMaxLength = e->maxLength;
+        ostringstream oss;
+        oss << fixed << setprecision(3)
+            << "{\"event\":\"improve\",\"time\":" << e->time << ",\"worker\":" << e->workerId
+            << ",\"iteration\":" << e->iteration << ",\"obj\":" << e->maxLength;
+        if (!e->centers.empty()) {
+            oss << ",\"centers\":[";
+            for (auto c = e->centers.begin(); c != e->centers.end(); ++c) {
+                oss << ((c == e->centers.begin()) ? "" : ",") << (*c + 1);
+            }
+            oss << "]";
+        }
+        oss << "}";
+        write(oss.str());
+    }
+    events.clear();
+}
+
+void Solver::ProgressStream::heartbeat(const char *eventName) {
+    Iteration iteration = 0;
+    int dropNum = 0;
+    for (auto c = channels.begin(); c != channels.end(); ++c) {
+        iteration += c->iteration.load(memory_order_relaxed);
+        dropNum += c->dropNum.load(memory_order_relaxed);
+    }
+    double time = solver.timer.elapsedSeconds();
+    double movesPerSecond = (time > lastTime) ? ((iteration - lastIteration) / (time - lastTime)) : 0;
+    lastIteration = iteration;
+    lastTime = time;
+
+    ostringstream oss;
+    oss << fixed << setprecision(3)
+        << "{\"event\":\"" << eventName << "\",\"time\":" << time << ",\"iteration\":" << iteration
+        << ",\"movesPerSecond\":" << movesPerSecond << ",\"obj\":";
+    if (bestMaxLength < INT32_MAX) { oss << bestMaxLength; } else { oss << "null"; }
+    oss << ",\"dropped\":" << dropNum << "}";
+    write(oss.str());
+}
+
+void Solver::ProgressStream::write(const String &line) {
+    if (sink) {
+        sink(line);
+    } else {
+        *os << line << endl;
+    }
+}
+#pragma endregion Solver::ProgressStream
+
 #pragma region Solver
 bool Solver::solve() {
     init();
 
     int workerNum = (max)(1, env.jobNum / cfg.threadNumPerWorker);
     cfg.threadNumPerWorker = env.jobNum / workerNum;
+    if (!resume(workerNum) && !warmStart(workerNum)) { construct(workerNum); }
+    reduce();
+
     List<Solution> solutions(workerNum, Solution(this));
     List<bool> success(workerNum);
 
+    if (!env.slnPath.empty()) { solutionWriter.start(); }
+    progress.start(workerNum);
+
     Log(LogSwitch::Szx::Framework) << "launch " << workerNum << " workers." << endl;
     List<thread> threadList;
     threadList.reserve(workerNum);
@@ -169,6 +601,8 @@ bool Solver::solve() {
         threadList.emplace_back([&, i]() { success[i] = optimize(solutions[i], i); });
     }
     for (int i = 0; i < workerNum; ++i) { threadList.at(i).join(); }
+    solutionWriter.stop();
+    progress.stop();
 
     Log(LogSwitch::Szx::Framework) << "collect best result among all workers." << endl;
     int bestIndex = -1;
@@ -210,7 +644,8 @@ void Solver::record() const {
         << mu.physicalMemory << "," << mu.virtualMemory << ","
         << env.randSeed << ","
         << cfg.toBriefStr() << ","
-        << generation << "," << iteration << ",";
+        << generation << "," << iteration << ","
+        << timeToTarget << ",";
         
 
     // record solution vector.
@@ -224,7 +659,7 @@ void Solver::record() const {
     ofstream logFile(env.logPath, ios::app);
     logFile.seekp(0, ios::end);
     if (logFile.tellp() <= 0) {
-        logFile << "Time,ID,Instance,Feasible,ObjMatch,Width,Duration,PhysMem,VirtMem,RandSeed,Config,Generation,Iteration" << endl;
+        logFile << "Time,ID,Instance,Feasible,ObjMatch,Width,Duration,PhysMem,VirtMem,RandSeed,Config,Generation,Iteration,TimeToTarget" << endl;
     }
     logFile << log.str();
     logFile.close();
@@ -233,16 +668,38 @@ void Solver::record() const {
 
 bool Solver::check(Length &checkerObj) const {
     #if JQ_DEBUG
-    enum CheckerFlag {
-        IoError = 0x0,
-        FormatError = 0x1,
-        CenterRepeatedError = 0x2,
-    };
+    using CheckerFlag = CheckConstraints::ErrorFlag;
+
+    // the same rules as the checker, but on the loaded instance without spawning it.
+    List<ID> centers;
+    int error = CheckConstraints::checkCenters(input.nodeNum, aux.centerNum, output.centers().begin(), output.centers().end(), centers);
 
-    checkerObj = System::exec("Checker.exe " + env.instPath + " " + env.solutionPathWithTime());
-    if (checkerObj > 0) { return true; }
-    checkerObj = ~checkerObj;
-    if (checkerObj == CheckerFlag::IoError) { Log(LogSwitch::Checker) << "IoError." << endl; }
+    if (error == 0) {
+        if (input.distMatrix || (input.metric != Problem::Metric::Explicit)) { // O(pn) without the graph.
+            DistanceOracle oracle;
+            if (!input.distMatrix) { oracle.init(input); }
+            checkerObj = 0;
+            for (ID v = 0; v < input.nodeNum; ++v) {
+                Length d = INF;
+                for (auto c = centers.begin(); c != centers.end(); ++c) {
+                    d = (min)(d, input.distMatrix ? input.distMatrix[static_cast<size_t>(*c) * input.nodeNum + v] : oracle(*c, v));
+                }
+                checkerObj = (max)(checkerObj, d);
+            }
+        } else if (input.adjOffsets) {
+            checkerObj = CheckConstraints::multiSourceMaxLength(input.nodeNum, input.adjOffsets, input.adjNodes, input.adjLengths, centers);
+        } else {
+            CheckConstraints::Csr csr;
+            CheckConstraints::buildCsr(input.nodeNum, static_cast<int>(input.edgeList.size()), [&](int e, ID &source, ID &target, Length &length) {
+                source = input.edgeList[e].source;
+                target = input.edgeList[e].target;
+                length = input.edgeList[e].length;
+            }, csr);
+            checkerObj = CheckConstraints::multiSourceMaxLength(input.nodeNum, csr.offsets.data(), csr.nodes.data(), csr.lengths.data(), centers);
+        }
+        return true;
+    }
+    checkerObj = error;
     if (checkerObj & CheckerFlag::FormatError) { Log(LogSwitch::Checker) << "FormatError." << endl; }
     if (checkerObj & CheckerFlag::CenterRepeatedError) { Log(LogSwitch::Checker) << "CenterRepeatedError." << endl; }
     return false;
@@ -252,138 +709,776 @@ bool Solver::check(Length &checkerObj) const {
     #endif // JQ_DEBUG
 }
 
+void Solver::shortestPaths(const Problem::Input &input, List<List<Length>> &dist) {
+    ID nodeNum = input.nodeNum;
+    List<List<Length>> &G(dist);
+    if (input.distMatrix) { // precomputed in the binary instance or given by the TSPLIB instance.
+        G.resize(nodeNum);
+        for (ID i = 0; i < nodeNum; ++i) {
+            const Length *row = input.distMatrix + static_cast<size_t>(i) * nodeNum;
+            G[i].assign(row, row + nodeNum);
+        }
+        return;
+    }
+    if (input.metric != Problem::Metric::Explicit) {
+        DistanceOracle oracle;
+        oracle.init(input);
+        G.resize(nodeNum);
+        for (ID i = 0; i < nodeNum; ++i) {
+            G[i].resize(nodeNum);
+            oracle.row(i, G[i].data());
+        }
+        return;
+    }
+
+    G.assign(nodeNum, List<Length>(nodeNum, INF));
+    for (ID i = 0; i < nodeNum; ++i) { G[i][i] = 0; }
+    if (input.adjOffsets) {
+        for (ID u = 0; u < nodeNum; ++u) {
+            for (ID a = input.adjOffsets[u]; a < input.adjOffsets[u + 1]; ++a) { G[u][input.adjNodes[a]] = input.adjLengths[a]; }
+        }
+    } else {
+        for (auto edge = input.edgeList.begin(); edge != input.edgeList.end(); ++edge) {
+            G[edge->source][edge->target] = edge->length;
+            G[edge->target][edge->source] = edge->length;
+        }
+    }
+    for (ID k = 0; k < nodeNum; ++k) {
+        for (ID i = 0; i < nodeNum; ++i) {
+            if (G[i][k] == INF) { continue; }
+            for (ID j = 0; j < nodeNum; ++j) {
+                if ((G[k][j] != INF) && (G[i][j] > G[i][k] + G[k][j])) { G[i][j] = G[i][k] + G[k][j]; }
+            }
+        }
+    }
+}
+
 void Solver::init() {
-    
+    aux.nodeNum = input.nodeNum;
+    aux.centerNum = (env.centerNum > 0) ? env.centerNum : input.centernum();
+
+    if (!aux.table) {
+        shared_ptr<DistanceTable> table(make_shared<DistanceTable>());
+        buildDistanceTable(input, cfg, env.jobNum, *table);
+        aux.table = table;
+    }
+}
+
+void Solver::buildDistanceTable(const Problem::Input &input, const Configuration &cfg, int threadNum, DistanceTable &table) {
+    ID nodeNum = input.nodeNum;
+    if ((input.metric != Problem::Metric::Explicit) && (nodeNum > cfg.maxMatrixNodeNum)) {
+        Log(LogSwitch::Szx::Preprocess) << "compute the distances on demand for " << nodeNum << " nodes." << endl;
+        table.dist.clear();
+        table.oracle.init(input);
+        SpatialGrid grid;
+        grid.init(table.oracle);
+
+        // the queries are independent, so they are split among the threads.
+        int k = (min)(cfg.nearestNum, nodeNum);
+        threadNum = (max)(1, threadNum);
+        table.nearest.assign(nodeNum, List<ID>());
+        List<thread> threadList;
+        threadList.reserve(threadNum);
+        for (int t = 0; t < threadNum; ++t) {
+            threadList.emplace_back([&, t]() {
+                for (ID u = t; u < nodeNum; u += threadNum) { grid.nearest(u, k, table.nearest[u]); }
+            });
+        }
+        for (auto th = threadList.begin(); th != threadList.end(); ++th) { th->join(); }
+        return;
+    }
+
+    if (input.distMatrix) { // the matrix is kept alive by the table instead of being copied.
+        table.dist.clear();
+        table.matrix = input.distMatrix;
+        table.matrixNodeNum = static_cast<size_t>(nodeNum);
+        table.matrixStorage = input.storage;
+    } else {
+        shortestPaths(input, table.dist);
+    }
+
+    // rank all nodes by distance once so that the neighborhood queries need no sorting.
+    table.nearest.assign(nodeNum, List<ID>(nodeNum));
+    for (ID u = 0; u < nodeNum; ++u) {
+        List<ID> &rank(table.nearest[u]);
+        for (ID v = 0; v < nodeNum; ++v) { rank[v] = v; }
+        const Length *distU = table.row(u);
+        sort(rank.begin(), rank.end(), [&](ID l, ID r) { return distU[l] < distU[r]; });
+    }
+}
+
+bool Solver::updateGraph(Problem::Input &input, const List<Problem::Edge> &delta, DistanceTable &table) {
+    if (input.distMatrix || (input.metric != Problem::Metric::Explicit) || table.isOnDemand()) { return false; }
+    ID nodeNum = input.nodeNum;
+    auto pairKey = [nodeNum](ID u, ID v) { return static_cast<long long>((min)(u, v)) * nodeNum + (max)(u, v); };
+
+    // the edges in the binary instance are listed in both directions.
+    if (input.adjOffsets) {
+        input.edgeList.clear();
+        for (ID u = 0; u < nodeNum; ++u) {
+            for (ID a = input.adjOffsets[u]; a < input.adjOffsets[u + 1]; ++a) {
+                if (u < input.adjNodes[a]) { input.edgeList.push_back({ u, input.adjNodes[a], input.adjLengths[a] }); }
+            }
+        }
+        input.adjOffsets = nullptr;
+        input.adjNodes = nullptr;
+        input.adjLengths = nullptr;
+        input.storage.reset();
+    }
+
+    // the length of a pair is given by its last edge as in shortestPaths().
+    struct Change { ID u; ID v; Length oldLength; Length newLength; };
+    unordered_map<long long, Change> changes;
+    for (auto e = delta.begin(); e != delta.end(); ++e) {
+        if ((e->source < 0) || (e->source >= nodeNum) || (e->target < 0) || (e->target >= nodeNum)) { return false; }
+        if (e->source == e->target) { continue; }
+        Change &c(changes.insert({ pairKey(e->source, e->target), { e->source, e->target, INF, INF } }).first->second);
+        c.newLength = (e->length < 0) ? INF : e->length;
+    }
+    unordered_map<long long, size_t> lastEdges;
+    List<Problem::Edge> edges;
+    edges.reserve(input.edgeList.size() + changes.size());
+    for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+        long long key = pairKey(e->source, e->target);
+        auto c = changes.find(key);
+        if (c != changes.end()) {
+            c->second.oldLength = e->length;
+            continue;
+        }
+        auto last = lastEdges.find(key);
+        if (last == lastEdges.end()) {
+            lastEdges[key] = edges.size();
+            edges.push_back(*e);
+        } else {
+            edges[last->second] = *e;
+        }
+    }
+    for (auto c = changes.begin(); c != changes.end(); ++c) {
+        if (c->second.newLength < INF) { edges.push_back({ c->second.u, c->second.v, c->second.newLength }); }
+    }
+    input.edgeList.swap(edges);
+
+    List<List<Length>> &G(table.dist);
+    List<bool> isChanged(nodeNum, false); // the rank of node i should be sorted again.
+
+    // a shorter edge (u, v) only shortens the paths through it, i.e., dist[i][u] + w + dist[v][j].
+    for (auto c = changes.begin(); c != changes.end(); ++c) {
+        if (c->second.newLength >= c->second.oldLength) { continue; }
+        Length w = c->second.newLength;
+        for (int dir = 0; dir < 2; ++dir) {
+            ID u = (dir == 0) ? c->second.u : c->second.v;
+            ID v = (dir == 0) ? c->second.v : c->second.u;
+            for (ID i = 0; i < nodeNum; ++i) {
+                Length du = G[i][u];
+                if ((du == INF) || (du + w >= G[i][v])) { continue; }
+                List<Length> &distI(G[i]);
+                const List<Length> &distV(G[v]);
+                for (ID j = 0; j < nodeNum; ++j) {
+                    if ((distV[j] == INF) || (du + w + distV[j] >= distI[j])) { continue; }
+                    distI[j] = du + w + distV[j];
+                    isChanged[i] = true;
+                    isChanged[j] = true;
+                }
+            }
+        }
+    }
+
+    // the distances from node i do not change if no longer edge is on its shortest path tree.
+    List<ID> sources;
+    for (ID i = 0; i < nodeNum; ++i) {
+        for (auto c = changes.begin(); c != changes.end(); ++c) {
+            const Change &ch(c->second);
+            if ((ch.newLength <= ch.oldLength) || (ch.oldLength == INF)) { continue; }
+            Length du = G[i][ch.u];
+            Length dv = G[i][ch.v];
+            if (((du != INF) && (du + ch.oldLength == dv)) || ((dv != INF) && (dv + ch.oldLength == du))) {
+                sources.push_back(i);
+                break;
+            }
+        }
+    }
+    if (!sources.empty()) {
+        List<ID> offsets(nodeNum + 1, 0);
+        for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+            ++offsets[e->source + 1];
+            ++offsets[e->target + 1];
+        }
+        for (ID u = 0; u < nodeNum; ++u) { offsets[u + 1] += offsets[u]; }
+        List<ID> adjNodes(offsets.back());
+        List<Length> adjLengths(offsets.back());
+        List<ID> next(offsets.begin(), offsets.end() - 1);
+        for (auto e = input.edgeList.begin(); e != input.edgeList.end(); ++e) {
+            adjNodes[next[e->source]] = e->target;
+            adjLengths[next[e->source]++] = e->length;
+            adjNodes[next[e->target]] = e->source;
+            adjLengths[next[e->target]++] = e->length;
+        }
+
+        using Entry = pair<Length, ID>;
+        List<Length> dist;
+        for (auto s = sources.begin(); s != sources.end(); ++s) {
+            dist.assign(nodeNum, INF);
+            dist[*s] = 0;
+            priority_queue<Entry, List<Entry>, greater<Entry>> q;
+            q.push({ 0, *s });
+            while (!q.empty()) {
+                Entry top = q.top();
+                q.pop();
+                if (top.first > dist[top.second]) { continue; }
+                for (ID a = offsets[top.second]; a < offsets[top.second + 1]; ++a) {
+                    Length d = top.first + adjLengths[a];
+                    if (d < dist[adjNodes[a]]) {
+                        dist[adjNodes[a]] = d;
+                        q.push({ d, adjNodes[a] });
+                    }
+                }
+            }
+            for (ID j = 0; j < nodeNum; ++j) {
+                if (dist[j] == G[*s][j]) { continue; }
+                isChanged[*s] = true;
+                isChanged[j] = true;
+            }
+            G[*s].swap(dist);
+        }
+    }
+
+    for (ID u = 0; u < nodeNum; ++u) {
+        if (!isChanged[u]) { continue; }
+        const List<Length> &distU(G[u]);
+        sort(table.nearest[u].begin(), table.nearest[u].end(), [&](ID l, ID r) { return distU[l] < distU[r]; });
+    }
+    Log(LogSwitch::Szx::Preprocess) << "repair the distances with " << changes.size() << " edge changes and "
+        << sources.size() << " recomputed sources." << endl;
+    return true;
+}
+
+size_t Solver::DistanceTable::memoryUsage() const {
+    size_t size = sizeof(DistanceTable) + oracle.nodeNum() * 2 * sizeof(double) + matrixNodeNum * matrixNodeNum * sizeof(Length);
+    for (auto row = dist.begin(); row != dist.end(); ++row) { size += row->capacity() * sizeof(Length); }
+    for (auto rank = nearest.begin(); rank != nearest.end(); ++rank) { size += rank->capacity() * sizeof(ID); }
+    return size;
+}
+
+void Solver::construct(int workerNum) {
+    int consNum = (max)(2, (max)(workerNum, cfg.constructionNum));
+    int threadNum = (min)(env.jobNum, consNum);
+    List<Construction> slns(consNum);
+
+    Log(LogSwitch::Szx::Framework) << "construct " << consNum << " initial solutions with " << threadNum << " threads." << endl;
+    List<thread> threadList;
+    threadList.reserve(threadNum);
+    for (int t = 0; t < threadNum; ++t) {
+        threadList.emplace_back([&, t]() {
+            Random r(randomStream(workerNum + t)); // workers take the first streams.
+            for (int i = t; i < consNum; i += threadNum) {
+                if ((i >= threadNum) && isCancelled()) { break; } // keep at least one.
+                construct(slns[i], r, (i % 2) == 0);
+            }
+        });
+    }
+    for (auto th = threadList.begin(); th != threadList.end(); ++th) { th->join(); }
+
+    // the farthest-first traversal is a 2-approximation, so half of its radius is a lower bound.
+    aux.lowerBound = 0;
+    aux.upperBound = INF;
+    for (int i = 0; i < consNum; ++i) {
+        if (slns[i].centers.empty()) { continue; } // skipped on cancellation.
+        if ((i % 2) == 0) { aux.lowerBound = (max)(aux.lowerBound, (slns[i].maxLength + 1) / 2); }
+        aux.upperBound = (min)(aux.upperBound, slns[i].maxLength);
+    }
+    slns.erase(remove_if(slns.begin(), slns.end(), [](const Construction &sln) { return sln.centers.empty(); }), slns.end());
+
+    for (auto sln = slns.begin(); sln != slns.end(); ++sln) { sort(sln->centers.begin(), sln->centers.end()); }
+    sort(slns.begin(), slns.end(), [](const Construction &l, const Construction &r) {
+        return (l.maxLength != r.maxLength) ? (l.maxLength < r.maxLength) : (l.centers < r.centers);
+    });
+    slns.erase(unique(slns.begin(), slns.end(), [](const Construction &l, const Construction &r) {
+        return l.centers == r.centers;
+    }), slns.end());
+
+    // seed the workers with the best distinct solutions (reuse them if there are not enough).
+    aux.initSlns.clear();
+    aux.initSlns.reserve(workerNum);
+    for (int w = 0; w < workerNum; ++w) { aux.initSlns.push_back(slns[w % slns.size()]); }
+    Log(LogSwitch::Szx::Framework) << "best initial maxLength=" << slns.front().maxLength << endl;
+}
+
+void Solver::construct(Construction &sln, Random &r, bool onFarthest) const {
+    List<Length> distToCenter(aux.nodeNum, INF);
+    List<Length> distBuf;
+    List<ID> centers;
+    swap(centers, sln.centers);
+    if (centers.empty()) { centers.push_back(r.pick(aux.nodeNum)); }
+    sln.centers.reserve(aux.centerNum);
+
+    for (auto c = centers.begin(); c != centers.end(); ++c) {
+        sln.centers.push_back(*c);
+        const Length *distC = aux.distances(*c, distBuf);
+        for (ID v = 0; v < aux.nodeNum; ++v) {
+            if (distC[v] < distToCenter[v]) { distToCenter[v] = distC[v]; }
+        }
+    }
+    sln.maxLength = *max_element(distToCenter.begin(), distToCenter.end());
+
+    while (static_cast<int>(sln.centers.size()) < aux.centerNum) {
+
+        // break ties among the farthest nodes randomly.
+        ID farthest = 0;
+        Sampling sampler(r, 1);
+        for (ID v = 0; v < aux.nodeNum; ++v) {
+            if ((distToCenter[v] == sln.maxLength) && sampler.isPicked()) { farthest = v; }
+        }
+        ID center = farthest;
+        if (!onFarthest && (sln.maxLength > 0)) {
+            // pick among the kClosed nearest nodes which are closer to the farthest node than its current center.
+            static constexpr int kClosed = 50;
+            sampler.reset();
+            const List<ID> &rank(aux.table->nearest[farthest]);
+            for (int i = 0, k = 0; (i < static_cast<int>(rank.size())) && (k < kClosed); ++i) {
+                ID v = rank[i];
+                if (distToCenter[v] == 0) { continue; } // already a center.
+                if (aux.distance(farthest, v) >= sln.maxLength) { break; }
+                ++k;
+                if (sampler.isPicked()) { center = v; }
+            }
+        }
+
+        sln.centers.push_back(center);
+        const Length *distC = aux.distances(center, distBuf);
+        sln.maxLength = 0;
+        for (ID v = 0; v < aux.nodeNum; ++v) {
+            if (distC[v] < distToCenter[v]) { distToCenter[v] = distC[v]; }
+            if (distToCenter[v] > sln.maxLength) { sln.maxLength = distToCenter[v]; }
+        }
+    }
+}
+
+bool Solver::warmStart(int workerNum) {
+    List<ID> centers(initCenters);
+    if (centers.empty()) {
+        if (env.initPath.empty()) { return false; }
+
+        Problem::Output initSln;
+        if (!initSln.load(env.initPath)) {
+            Log(LogSwitch::Szx::Input) << "fail to load initial solution " << env.initPath << "." << endl;
+            return false;
+        }
+        for (auto c = initSln.centers().begin(); c != initSln.centers().end(); ++c) { centers.push_back(*c - 1); }
+    }
+
+    // drop invalid or repeated centers, and complete or shrink the solution if its size differs.
+    Construction sln;
+    List<bool> isCenter(aux.nodeNum, false);
+    for (auto c = centers.begin(); c != centers.end(); ++c) {
+        if ((*c < 0) || (*c >= aux.nodeNum) || isCenter[*c]) { continue; }
+        isCenter[*c] = true;
+        sln.centers.push_back(*c);
+    }
+    shrink(sln);
+    Random r(rand);
+    construct(sln, r, true);
+
+    // the initial solutions are all replaced, so a single unseeded farthest-first traversal is enough for the bounds.
+    Construction bound;
+    construct(bound, r, true);
+    aux.lowerBound = (bound.maxLength + 1) / 2;
+    aux.upperBound = (min)(bound.maxLength, sln.maxLength);
+
+    Log(LogSwitch::Szx::Input) << "warm start with maxLength=" << sln.maxLength << endl;
+    aux.initSlns.assign(workerNum, sln);
+    return true;
+}
+
+void Solver::shrink(Construction &sln) const {
+    List<Length> distBuf;
+    List<Length> d0(aux.nodeNum);
+    List<Length> d1(aux.nodeNum);
+    List<int> f0(aux.nodeNum);
+    while (static_cast<int>(sln.centers.size()) > aux.centerNum) {
+        // the nearest and the second nearest centers of each node.
+        int centerNum = static_cast<int>(sln.centers.size());
+        fill(d0.begin(), d0.end(), INF);
+        fill(d1.begin(), d1.end(), INF);
+        for (int i = 0; i < centerNum; ++i) {
+            const Length *distC = aux.distances(sln.centers[i], distBuf);
+            for (ID v = 0; v < aux.nodeNum; ++v) {
+                if (distC[v] < d0[v]) {
+                    d1[v] = d0[v];
+                    d0[v] = distC[v];
+                    f0[v] = i;
+                } else if (distC[v] < d1[v]) {
+                    d1[v] = distC[v];
+                }
+            }
+        }
+
+        // the nodes served by center i are served by their second nearest centers without it.
+        List<Length> servedRadius(centerNum, 0);
+        List<Length> orphanRadius(centerNum, 0);
+        for (ID v = 0; v < aux.nodeNum; ++v) {
+            servedRadius[f0[v]] = (max)(servedRadius[f0[v]], d0[v]);
+            orphanRadius[f0[v]] = (max)(orphanRadius[f0[v]], d1[v]);
+        }
+        int top = 0;
+        for (int i = 1; i < centerNum; ++i) { if (servedRadius[i] > servedRadius[top]) { top = i; } }
+        Length secondRadius = 0;
+        for (int i = 0; i < centerNum; ++i) { if (i != top) { secondRadius = (max)(secondRadius, servedRadius[i]); } }
+
+        int dropped = 0;
+        Length minRadius = INF;
+        for (int i = 0; i < centerNum; ++i) {
+            Length radius = (max)(orphanRadius[i], (i == top) ? secondRadius : servedRadius[top]);
+            if (radius < minRadius) {
+                minRadius = radius;
+                dropped = i;
+            }
+        }
+        sln.centers.erase(sln.centers.begin() + dropped);
+    }
+}
+
+bool Solver::resume(int workerNum) {
+    if (env.rsmPath.empty()) { return false; }
+
+    List<Construction> slns;
+    for (int w = 0; w < workerNum; ++w) {
+        Worker worker(*this, w, rand);
+        if (!worker.loadCheckpoint(env.resumePath(w), &aux.lowerBound, &aux.upperBound)) { continue; }
+        slns.push_back({ worker.getCenters(), worker.getMaxLength() });
+    }
+    if (slns.empty()) {
+        Log(LogSwitch::Szx::Input) << "no checkpoint found in " << env.rsmPath << "." << endl;
+        return false;
+    }
+
+    // workers without checkpoints start from the best resumed solution.
+    auto best = min_element(slns.begin(), slns.end(), [](const Construction &l, const Construction &r) {
+        return l.maxLength < r.maxLength;
+    });
+    aux.initSlns.assign(workerNum, *best);
+    return true;
+}
+
+void Solver::reduce() {
+    aux.isCandidate.assign(aux.nodeNum, true);
+    int candidateNum = aux.nodeNum;
+    for (ID u = 0; u < aux.nodeNum; ++u) {
+        const List<ID> &rank(aux.table->nearest[u]);
+        // a truncated list proves nothing unless it reaches beyond the upper bound, see dominate().
+        if ((static_cast<ID>(rank.size()) < aux.nodeNum) && (aux.distance(u, rank.back()) <= aux.upperBound)) { continue; }
+        // u must be covered by its substitute in all radii in the bounds.
+        for (auto w = rank.begin(); (w != rank.end()) && (aux.distance(u, *w) <= aux.lowerBound); ++w) {
+            if ((*w == u) || !aux.isCandidate[*w] || !dominate(*w, u)) { continue; }
+            if ((*w > u) && dominate(u, *w)) { continue; } // keep the smallest ID among equivalent nodes.
+            aux.isCandidate[u] = false;
+            --candidateNum;
+            break;
+        }
+    }
+
+    aux.nearest.resize(aux.nodeNum);
+    for (ID u = 0; u < aux.nodeNum; ++u) {
+        const List<ID> &rank(aux.table->nearest[u]);
+        aux.nearest[u].clear();
+        copy_if(rank.begin(), rank.end(), back_inserter(aux.nearest[u]), [&](ID v) { return aux.isCandidate[v]; });
+    }
+    Log(LogSwitch::Szx::Preprocess) << "keep " << candidateNum << " candidates for radius in ["
+        << aux.lowerBound << ", " << aux.upperBound << "]." << endl;
+}
+
+bool Solver::dominate(ID w, ID u) const {
+    // for any radius r >= lowerBound, dist[u][v] <= r implies dist[w][v] <= r.
+    const List<ID> &rank(aux.table->nearest[u]);
+    for (auto v = rank.begin(); v != rank.end(); ++v) {
+        Length distU = aux.distance(u, *v);
+        if (distU > aux.upperBound) { return true; }
+        if (aux.distance(w, *v) > (max)(distU, aux.lowerBound)) { return false; }
+    }
+    // the nodes out of the truncated list are unknown.
+    return (static_cast<ID>(rank.size()) == aux.nodeNum);
+}
+
+void Solver::reachTarget() {
+    bool reached = false;
+    if (!targetReached.compare_exchange_strong(reached, true)) { return; }
+    timeToTarget = chrono::duration<double>(Timer::Clock::now() - timer.getStartTime()).count();
+    cancellation.cancel();
+    Log(LogSwitch::Szx::Framework) << "reach target " << env.target << " in " << timeToTarget << "s." << endl;
+}
+
+Random Solver::randomStream(int streamId) const {
+    Random r(rand);
+    for (int i = 0; i <= streamId; ++i) { r.jump(); }
+    return r;
 }
 
 bool Solver::optimize(Solution &sln, ID workerId) {
     Log(LogSwitch::Szx::Framework) << "worker " << workerId << " starts." << endl;
-	vector<int> vec;
-    for (auto edge = input.graph().edges().begin(); edge != input.graph().edges().end(); ++edge) {
-        vec.push_back(edge->source());
-        vec.push_back(edge->target());
-    }
-    auto maxPosition = max_element(vec.begin(), vec.end());
-    nodeNum = *maxPosition;
-    edgeNum = input.graph().edges().size();
-    centerNum = input.centernum();
     bool status = true;
-    sln.maxLength = 0;
-	
-    // TODO[0]: replace the following random assignment with your own algorithm.
-	G.resize(nodeNum);
-	for (int i = 0; i < nodeNum; i++) {
-		G[i].resize(nodeNum);
-	}
-	for (int i = 0; i < nodeNum; ++i) {
-		for (int j = 0; j < nodeNum; ++j) {
-			G[i][j] = INT32_MAX;
-		}
-	}	
-	for (int i = 0; i < nodeNum; ++i)
-		G[i][i] = 0;
-    for (auto edge = input.graph().edges().begin(); edge != input.graph().edges().end(); ++edge) {
-        int source = edge->source();
-        int target = edge->target();
-        int length = edge->length();
-        G[source - 1][target - 1] = length;
-        G[target - 1][source - 1] = length;
-    }
-	for (int k = 0; k < nodeNum; ++k)
-		for (int i = 0; i < nodeNum; ++i)
-			for (int j = 0; j < nodeNum; ++j)
-				if (G[i][k] != INT32_MAX && G[k][j] != INT32_MAX &&
-					G[i][j] > G[i][k] + G[k][j])
-					G[i][j] = G[i][k] + G[k][j];
-	//ʼڵ
-	isServerdNode.assign(nodeNum, false);
-	int index = rand.pick(nodeNum);
-	dTable.assign(2, vector<int>(nodeNum, INF));
-	fTable.assign(2, vector<int>(nodeNum, -1));
-	centers.clear();
-	centers.push_back(index);
-	isServerdNode[index] = true;
-	fTable[0].assign(nodeNum, index);
-	dTable[0] = G[index];
-	for (int f = 1; f < centerNum; ++f) {//ӳʼڵ㿪ʼιڵ
-		int serverNode = selectNextSeveredNode();
-		addNodeToTable(serverNode);
-		cout << "inital maxLength : " << f <<"  "<< maxLength << endl;
-	}
-	//Գʼ
-	/*
-	for (int i = 0; i < centers.size(); ++i) {
-		sln.add_centers(centers[i] + 1);
-	}
-	int maxServerLength = -1, serveredNode = -1;
-	for (int v = 0; v < nodeNum; ++v) {
-		if (dTable[0][v] > maxServerLength) {
-			maxServerLength = dTable[0][v];
-			serveredNode = v;
-		}
-	}
-	sln.maxLength = maxServerLength;
-	*/
-	//ڵ
-	cout << "inital maxLength : " << maxLength << endl;
-	hist_maxLength = maxLength;
-	tableTenure.assign(nodeNum, vector<int>(nodeNum, 0));
+
+    Worker worker(*this, workerId, randomStream(workerId));
+    if (env.rsmPath.empty() || !worker.loadCheckpoint(env.resumePath(workerId))) {
+        worker.init(aux.initSlns[workerId].centers);
+    }
+    Log(LogSwitch::Szx::Framework) << "worker " << workerId << " inital maxLength=" << worker.getMaxLength() << endl;
+    solutionWriter.offer(worker.getMaxLength(), worker.getCenters());
+    worker.search(env.maxIter);
+
+    const List<ID> &centers(worker.getCenters());
+    for (int i = 0; i < static_cast<int>(centers.size()); ++i) {
+        sln.add_centers(centers[i] + 1);
+    }
+    sln.maxLength = worker.getMaxLength();
+    Log(LogSwitch::Szx::Framework) << "worker " << workerId << " ends with maxLength=" << sln.maxLength << endl;
+    return status;
+}
+#pragma endregion Solver
+
+#pragma region Solver::Worker
+void Solver::Worker::init(const List<ID> &initCenters) {
+    int nodeNum = aux.nodeNum;
+    centers = initCenters;
+    isServerdNode.assign(nodeNum, false);
+    for (auto c = centers.begin(); c != centers.end(); ++c) { isServerdNode[*c] = true; }
+    dTable.assign(2, List<int>(nodeNum, INF));
+    fTable.assign(2, List<int>(nodeNum, -1));
+    for (auto c = centers.begin(); c != centers.end(); ++c) {
+        const Length *distC = aux.distances(*c, distBuf);
+        for (ID v = 0; v < nodeNum; ++v) {
+            Length d = distC[v];
+            if (d < dTable[0][v]) {
+                dTable[1][v] = dTable[0][v];
+                fTable[1][v] = fTable[0][v];
+                dTable[0][v] = d;
+                fTable[0][v] = *c;
+            } else if (d < dTable[1][v]) {
+                dTable[1][v] = d;
+                fTable[1][v] = *c;
+            }
+        }
+    }
+    maxLength = *max_element(dTable[0].begin(), dTable[0].end());
+    hist_maxLength = maxLength;
+    clearTenure();
+    iteration = 0;
+    bestMaxLength = maxLength;
+    bestCenters = centers;
+    #if JQ_DEBUG
+    verifier.reset(*this);
+    #endif // JQ_DEBUG
+}
+
+void Solver::Worker::clearTenure() {
+    sparseTenure.clear();
+    if (aux.isOnDemand()) {
+        tableTenure.clear();
+    } else {
+        tableTenure.assign(static_cast<size_t>(aux.nodeNum) * aux.nodeNum, 0);
+    }
+}
+
+void Solver::Worker::search(Iteration maxIter) {
 	vector<int> switchNodes;
 	vector<vector<int>> switchNodePairs;
 	vector<int> switchNodePair;
-	for (int t = 0; t < 10000; ++t) {
+	Timer::TimePoint ckptTime = Timer::Clock::now() + Timer::Millisecond(solver.cfg.msCheckpointInterval);
+	solver.progress.improve(id, iteration, bestMaxLength, bestCenters);
+	if (bestMaxLength <= solver.env.target) { solver.reachTarget(); }
+	for (; iteration < maxIter; ++iteration) {
+        solver.progress.count(id, iteration);
+        if (solver.isCancelled()) { break; }
+        if (((iteration & DeadlineCheckIterMask) == 0) && solver.timer.isTimeOut()) {
+            solver.cancellation.cancel(); // the other workers stop without reading the clock.
+            break;
+        }
+        if (!solver.env.ckptPath.empty() && ((iteration & CheckIterMask) == 0) && (Timer::Clock::now() >= ckptTime)) {
+            saveCheckpoint(solver.env.checkpointPath(id)); // the state before this iteration.
+            ckptTime = Timer::Clock::now() + Timer::Millisecond(solver.cfg.msCheckpointInterval);
+        }
+        if ((iteration & CheckIterMask) == 0) { // drop the expired tabu entries.
+            for (auto t = sparseTenure.begin(); t != sparseTenure.end();) {
+                t = (t->second <= iteration) ? sparseTenure.erase(t) : next(t);
+            }
+        }
+
+        int t = iteration;
         switchNodePair.clear();
         switchNodes.clear();
         switchNodePairs.clear();
 		switchNodes = findSeveredNodeNeighbourhood();//ڵ
-        //for (int i = 0; i < switchNodes.size(); ++i) {
-        //     cout << "witchnode:  "<<switchNodes[i] << "   length:  "<<dTable[0][switchNodes[i]] << endl;
-        //}
 		switchNodePairs = findPair(switchNodes, t);//ڵԣͬMfȫ
 		if (switchNodePairs.size() == 0)
 			continue;
 		switchNodePair = switchNodePairs[rand.pick(switchNodePairs.size())];//ڵ
 		int f = switchNodePair[0], v = switchNodePair[1], minMaxlength = switchNodePair[2];
-        //cout << "f :" << f << "   v :" << v << endl;
 		addNodeToTable(f);
-        //cout << "add f length: " << maxLength << endl;
 		deleteNodeInTable(v);
-        //cout << "delete v length: " << maxLength << endl;
-		tableTenure[f][v] = t + step_tenure;//ɷڽһʱڱûڵ
+		setTenure(f, v, t + step_tenure);//ɷڽһʱڱûڵ
 
+        if (maxLength < bestMaxLength) {
+            bestMaxLength = maxLength;
+            bestCenters = centers;
+            solver.solutionWriter.offer(bestMaxLength, bestCenters);
+            solver.progress.improve(id, iteration, bestMaxLength, bestCenters);
+            if (bestMaxLength <= solver.env.target) { solver.reachTarget(); }
+        }
 	}
-	for (int i = 0; i < centers.size(); ++i) {
-		sln.add_centers(centers[i] + 1);
-	}
-	sln.maxLength = maxLength;
-	cout << "maxLength after change: " << maxLength << endl;
-    Log(LogSwitch::Szx::Framework) << "worker " << workerId << " ends." << endl;
-    return status;
+    solver.progress.count(id, iteration);
+    if (!solver.env.ckptPath.empty()) { saveCheckpoint(solver.env.checkpointPath(id)); }
+}
+
+namespace {
+constexpr char CheckpointMagic[] = { 'P', 'C', 'K', '2' };
+
+template<typename T>
+void writeBinary(ostream &os, const T &obj) { os.write(reinterpret_cast<const char*>(&obj), sizeof(obj)); }
+template<typename T>
+void writeBinary(ostream &os, const List<T> &list) {
+    int size = static_cast<int>(list.size());
+    writeBinary(os, size);
+    os.write(reinterpret_cast<const char*>(list.data()), sizeof(T) * size);
+}
+
+template<typename T>
+bool readBinary(istream &is, T &obj) { return static_cast<bool>(is.read(reinterpret_cast<char*>(&obj), sizeof(obj))); }
+template<typename T>
+bool readBinary(istream &is, List<T> &list, int maxSize) {
+    int size;
+    if (!readBinary(is, size) || (size < 0) || (size > maxSize)) { return false; }
+    list.resize(size);
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(list.data()), sizeof(T) * size));
+}
+
+// return true if there are centerNum distinct centers in [0, nodeNum), which are marked in isCenter.
+bool markCenters(const List<ID> &centers, int centerNum, int nodeNum, List<bool> &isCenter) {
+    if (static_cast<int>(centers.size()) != centerNum) { return false; }
+    isCenter.assign(nodeNum, false);
+    for (auto c = centers.begin(); c != centers.end(); ++c) {
+        if ((*c < 0) || (*c >= nodeNum) || isCenter[*c]) { return false; }
+        isCenter[*c] = true;
+    }
+    return true;
+}
+}
+
+bool Solver::Worker::saveCheckpoint(const String &path) const {
+    String tmpPath(path + ".tmp");
+    ofstream ofs(tmpPath, ios::binary);
+    if (!ofs.is_open()) { return false; }
+
+    ofs.write(CheckpointMagic, sizeof(CheckpointMagic));
+    writeBinary(ofs, aux.nodeNum);
+    writeBinary(ofs, aux.centerNum);
+    writeBinary(ofs, aux.lowerBound);
+    writeBinary(ofs, aux.upperBound);
+    writeBinary(ofs, iteration);
+    writeBinary(ofs, rand.rgen.state);
+    writeBinary(ofs, centers);
+    writeBinary(ofs, bestCenters);
+
+    // only the unexpired tabu entries are saved as (f, v, tenure) triples.
+    List<int> tabu;
+    auto saveTenure = [&](long long key, Iteration tenure) {
+        if (tenure <= iteration) { return; }
+        tabu.push_back(static_cast<ID>(key / aux.nodeNum));
+        tabu.push_back(static_cast<ID>(key % aux.nodeNum));
+        tabu.push_back(tenure);
+    };
+    for (size_t key = 0; key < tableTenure.size(); ++key) { saveTenure(key, tableTenure[key]); }
+    for (auto t = sparseTenure.begin(); t != sparseTenure.end(); ++t) { saveTenure(t->first, t->second); }
+    writeBinary(ofs, tabu);
+
+    ofs.close();
+    if (!ofs) { return false; }
+    return System::moveFile(tmpPath, path);
+}
+
+bool Solver::Worker::loadCheckpoint(const String &path, Length *lowerBound, Length *upperBound) {
+    ifstream ifs(path, ios::binary);
+    if (!ifs.is_open()) { return false; }
+
+    char magic[sizeof(CheckpointMagic)];
+    int nodeNum;
+    int centerNum;
+    Length lb;
+    Length ub;
+    if (!ifs.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), CheckpointMagic)) { return false; }
+    if (!readBinary(ifs, nodeNum) || (nodeNum != aux.nodeNum)) { return false; }
+    if (!readBinary(ifs, centerNum) || (centerNum != aux.centerNum)) { return false; }
+    if (!readBinary(ifs, lb) || !readBinary(ifs, ub)) { return false; }
+
+    // the state is read aside and only taken after it is checked, since the indices are used without checking.
+    Iteration iter;
+    decltype(rand.rgen.state) randState;
+    List<ID> ckptCenters;
+    List<ID> ckptBestCenters;
+    List<int> tabu;
+    bool ok = readBinary(ifs, iter) && readBinary(ifs, randState)
+        && readBinary(ifs, ckptCenters, centerNum) && readBinary(ifs, ckptBestCenters, centerNum)
+        && readBinary(ifs, tabu, 3 * nodeNum); // at most one entry is added in each iteration.
+    if (!ok || (tabu.size() % 3 != 0)) { return false; }
+
+    List<bool> isCenter;
+    if (!markCenters(ckptBestCenters, centerNum, nodeNum, isCenter)) { return false; }
+    if (!markCenters(ckptCenters, centerNum, nodeNum, isCenter)) { return false; }
+    for (auto t = tabu.begin(); t != tabu.end(); t += 3) {
+        if ((*t < 0) || (*t >= nodeNum) || (*(t + 1) < 0) || (*(t + 1) >= nodeNum)) { return false; }
+    }
+
+    // the tables and lengths are rebuilt on the current instance, so a checkpoint of another
+    // instance with the same size only gives a worse start instead of a wrong objective.
+    init(ckptCenters);
+    List<Length> distToCenter(nodeNum, INF);
+    for (auto c = ckptBestCenters.begin(); c != ckptBestCenters.end(); ++c) {
+        const Length *distC = aux.distances(*c, distBuf);
+        for (ID v = 0; v < nodeNum; ++v) {
+            if (distC[v] < distToCenter[v]) { distToCenter[v] = distC[v]; }
+        }
+    }
+    Length bestLength = *max_element(distToCenter.begin(), distToCenter.end());
+    if (bestLength < bestMaxLength) {
+        bestMaxLength = bestLength;
+        bestCenters.swap(ckptBestCenters);
+    }
+
+    // the saved bounds only narrow the reduction, and the upper bound must be reachable.
+    if (lowerBound != nullptr) { *lowerBound = (min)(lb, bestMaxLength); }
+    if (upperBound != nullptr) { *upperBound = (min)(ub, bestMaxLength); }
+
+    iteration = iter;
+    copy(begin(randState), end(randState), begin(rand.rgen.state));
+    for (auto t = tabu.begin(); t != tabu.end(); t += 3) { setTenure(*t, *(t + 1), *(t + 2)); }
+    return true;
 }
 
-void Solver::addNodeToTable(int node)
+
+void Solver::Worker::addNodeToTable(ID node)
 {
     isServerdNode[node] = true;
 	maxLength = 0;
 	centers.push_back(node);
 	isServerdNode[node] = true;
-	for (int v = 0; v < nodeNum; ++v) {//ft
-		if (G[node][v] < dTable[0][v]) {
+	const Length *distNode = aux.distances(node, distBuf);
+	for (int v = 0; v < aux.nodeNum; ++v) {//ft
+		if (distNode[v] < dTable[0][v]) {
 			dTable[1][v] = dTable[0][v];
-			dTable[0][v] = G[node][v];
+			dTable[0][v] = distNode[v];
 			fTable[1][v] = fTable[0][v];
 			fTable[0][v] = node;
 		}
-		else if (G[node][v] < dTable[1][v]) {
-			dTable[1][v] = G[node][v];
+		else if (distNode[v] < dTable[1][v]) {
+			dTable[1][v] = distNode[v];
 			fTable[1][v] = node;
 		}
 		if (dTable[0][v] > maxLength)
 			maxLength = dTable[0][v];
 	}
+    #if JQ_DEBUG
+    verifier.verify(*this, node, true);
+    #endif // JQ_DEBUG
 }
 
-void Solver::deleteNodeInTable(int node)
+void Solver::Worker::deleteNodeInTable(ID node)
 {
     isServerdNode[node] = false;
     maxLength = 0;
@@ -393,7 +1488,7 @@ void Solver::deleteNodeInTable(int node)
 		centers[i] = centers[i + 1];
 	}
 	centers.pop_back();
-	for (int v = 0; v < nodeNum; ++v) {
+	for (int v = 0; v < aux.nodeNum; ++v) {
 		if (fTable[0][v] == node) {
 			fTable[0][v] = fTable[1][v];
 			dTable[0][v] = dTable[1][v];
@@ -406,15 +1501,20 @@ void Solver::deleteNodeInTable(int node)
 		if (dTable[0][v] > maxLength)
 			maxLength = dTable[0][v];
 	}
+    #if JQ_DEBUG
+    verifier.verify(*this, node, false);
+    #endif // JQ_DEBUG
 }
 
-void Solver::findNext(int v)
+void Solver::Worker::findNext(ID v)
 {	
 	int nextNode = -1, secondLength = INF;
 	for (int i = 0; i < centers.size(); ++i) {
 		int f = centers[i];//Ѱһνڵ
-		if (f != fTable[0][v] && G[v][f] < secondLength) {
-			secondLength = G[v][f]; 
+		if (f == fTable[0][v]) { continue; }
+		Length d = aux.distance(v, f);
+		if (d < secondLength) {
+			secondLength = d;
 			nextNode = f;
 		}
 	}
@@ -422,18 +1522,11 @@ void Solver::findNext(int v)
 	fTable[1][v] = nextNode;
 }
 
-int Solver::selectNextSeveredNode()
-{
-	vector<int> kClosedNode = findSeveredNodeNeighbourhood();
-	int serveredNode = kClosedNode[rand.pick(kClosedNode.size())];//kڵѡһΪڵ
-	return serveredNode;
-}
-
-vector<int> Solver::findSeveredNodeNeighbourhood()
+List<ID> Solver::Worker::findSeveredNodeNeighbourhood()
 {
 	int maxServerLength = -1;
 	vector<int> serveredNodes;
-	for (int v = 0; v < nodeNum; ++v) {
+	for (int v = 0; v < aux.nodeNum; ++v) {
 		if (dTable[0][v] > maxServerLength) {
 			serveredNodes.clear();
 			maxServerLength = dTable[0][v];
@@ -445,32 +1538,28 @@ vector<int> Solver::findSeveredNodeNeighbourhood()
 	}
 	int serveredNode = serveredNodes[rand.pick(serveredNodes.size())];
 	vector<int> kClosedNode; //ѡûڵvǰkڵ
-	kClosedNode = sortIndexes(G[serveredNode], kClosed, maxServerLength);
+	kClosedNode = sortIndexes(serveredNode, kClosed, maxServerLength);
 	return kClosedNode;
 }
 
-vector<int> Solver::sortIndexes(const vector<int>& v, int k,int length)
+List<ID> Solver::Worker::sortIndexes(ID node, int k, Length length)
 {
 	//ǰkСֵӦֵ
-	vector<int> idx(v.size());
+	const List<ID> &idx(aux.nearest[node]);
 	vector<int> res;
-	for (int i = 0; i != idx.size(); ++i) {
-		idx[i] = i;
-	}
-	sort(idx.begin(), idx.end(),
-		[&v](int i1, int i2) {return v[i1] < v[i2]; });
-	for (int i = 0; i < k; i++) {
+	for (int i = 0; (i < k) && (i < idx.size()); i++) {
 		if (isServerdNode[idx[i]]) {
 			++k;
 			continue;
 		}
-		if (v[idx[i]] < length)
-			res.push_back(idx[i]);
+		if (aux.distance(node, idx[i]) >= length)
+			break;
+		res.push_back(idx[i]);
 	}
 	return res;
 }
 
-vector<vector<int>> Solver::findPair(const vector<int>& switchNode, int t)
+List<List<int>> Solver::Worker::findPair(const List<ID>& switchNode, int t)
 {
 	int minMaxLength = INF;//ԭʼĿ꺯ֵ
 	vector<vector<int>> res;
@@ -481,13 +1570,14 @@ vector<vector<int>> Solver::findPair(const vector<int>& switchNode, int t)
 		for (int j = 0; j < centers.size(); ++j) {
 			Mf[centers[j]] = 0;
 		}
+		const Length *distI = aux.distances(i, distBuf);
 		for (int v = 0; v < dTable[0].size(); ++v) {
-			if (min(G[i][v], dTable[1][v]) > Mf[fTable[0][v]])
-				Mf[fTable[0][v]] = min(G[i][v], dTable[1][v]);
+			if (min(distI[v], dTable[1][v]) > Mf[fTable[0][v]])
+				Mf[fTable[0][v]] = min(distI[v], dTable[1][v]);
 		}
 		for (int f = 0; f < centers.size(); f++) {
 			//ѡɾfС
-			if (t < tableTenure[i][centers[f]] && Mf[centers[f]] >=  maxLength)
+			if (t < tenure(i, centers[f]) && Mf[centers[f]] >=  maxLength)
 				continue;
 			if (Mf[centers[f]] == minMaxLength) {
 				vector<int> r;
@@ -512,8 +1602,106 @@ vector<vector<int>> Solver::findPair(const vector<int>& switchNode, int t)
 	}
 	return  res;
 }
+#pragma endregion Solver::Worker
 
+#if JQ_DEBUG
+#pragma region Solver::Worker::DeltaVerifier
+void Solver::Worker::DeltaVerifier::reset(const Worker &worker) {
+    isCenter.assign(worker.aux.nodeNum, false);
+    centers = worker.centers;
+    for (auto c = centers.begin(); c != centers.end(); ++c) { isCenter[*c] = true; }
+    dTable.assign(2, List<Length>(worker.aux.nodeNum, INF));
+    for (ID v = 0; v < worker.aux.nodeNum; ++v) { recompute(worker, v); }
+    history.clear();
+    moveNum = 0;
 
-#pragma endregion Solver
+    for (ID v = 0; v < worker.aux.nodeNum; ++v) {
+        if ((worker.dTable[0][v] != dTable[0][v]) || (worker.dTable[1][v] != dTable[1][v])) {
+            report(worker, v, "the tables are built wrong");
+            break;
+        }
+    }
+}
+
+void Solver::Worker::DeltaVerifier::verify(const Worker &worker, ID node, bool isAdded) {
+    Move move = { worker.iteration, node, isAdded };
+    if (history.size() < HistoryLength) { history.push_back(move); } else { history[moveNum % HistoryLength] = move; }
+    ++moveNum;
+
+    if (isAdded) {
+        isCenter[node] = true;
+        centers.push_back(node);
+    } else {
+        isCenter[node] = false;
+        centers.erase(find(centers.begin(), centers.end(), node));
+    }
+
+    // an added center only serves the nodes closer to it than their second nearest centers, and a deleted
+    // center only served the nodes no farther from it than their second nearest centers.
+    touchedNodes.clear();
+    if ((moveNum % FullVerifyInterval) == 0) {
+        for (ID v = 0; v < worker.aux.nodeNum; ++v) { touchedNodes.push_back(v); }
+    } else {
+        const Length *distNode = worker.aux.distances(node, distBuf);
+        for (ID v = 0; v < worker.aux.nodeNum; ++v) {
+            if (isAdded ? (distNode[v] < dTable[1][v]) : (distNode[v] <= dTable[1][v])) { touchedNodes.push_back(v); }
+        }
+    }
+    for (auto v = touchedNodes.begin(); v != touchedNodes.end(); ++v) { recompute(worker, *v); }
+
+    if (worker.centers.size() != centers.size()) { return report(worker, node, "the number of centers differs"); }
+    for (auto v = touchedNodes.begin(); v != touchedNodes.end(); ++v) { // the centers in the f table.
+        ID f0 = worker.fTable[0][*v];
+        ID f1 = worker.fTable[1][*v];
+        if ((f0 < 0) || !isCenter[f0] || (worker.aux.distance(f0, *v) != dTable[0][*v])) {
+            return report(worker, *v, "the nearest center is wrong");
+        }
+        if ((f1 >= 0) && (!isCenter[f1] || (f1 == f0) || (worker.aux.distance(f1, *v) != dTable[1][*v]))) {
+            return report(worker, *v, "the second nearest center is wrong");
+        }
+    }
+    Length maxLength = 0;
+    for (ID v = 0; v < worker.aux.nodeNum; ++v) { // the untouched nodes should be left as they are.
+        if ((worker.dTable[0][v] != dTable[0][v]) || (worker.dTable[1][v] != dTable[1][v])) {
+            return report(worker, v, "the distance to the nearest centers is wrong");
+        }
+        maxLength = (max)(maxLength, dTable[0][v]);
+    }
+    if (worker.maxLength != maxLength) { return report(worker, node, "the max length is wrong"); }
+}
+
+void Solver::Worker::DeltaVerifier::recompute(const Worker &worker, ID v) {
+    Length d0 = INF;
+    Length d1 = INF;
+    for (auto c = centers.begin(); c != centers.end(); ++c) {
+        Length d = worker.aux.distance(*c, v);
+        if (d < d0) {
+            d1 = d0;
+            d0 = d;
+        } else if (d < d1) {
+            d1 = d;
+        }
+    }
+    dTable[0][v] = d0;
+    dTable[1][v] = d1;
+}
+
+void Solver::Worker::DeltaVerifier::report(const Worker &worker, ID v, const String &reason) {
+    if (reportNum++ >= MaxReportNum) { return; }
+
+    ostringstream oss;
+    oss << "worker " << worker.id << " at iteration " << worker.iteration << ": " << reason << " on node " << v
+        << ". expected d=(" << dTable[0][v] << ", " << dTable[1][v] << ") maxLength=" << *max_element(dTable[0].begin(), dTable[0].end())
+        << ", got d=(" << worker.dTable[0][v] << ", " << worker.dTable[1][v] << ") f=(" << worker.fTable[0][v] << ", "
+        << worker.fTable[1][v] << ") maxLength=" << worker.maxLength << ". recent moves:";
+    long long first = (max)(0LL, moveNum - static_cast<long long>(history.size()));
+    for (long long m = first; m < moveNum; ++m) {
+        const Move &move(history[m % HistoryLength]);
+        oss << " " << move.iteration << (move.isAdded ? "+" : "-") << move.node;
+    }
+    Log(LogSwitch::Checker) << oss.str() << endl;
+}
+#pragma endregion Solver::Worker::DeltaVerifier
+#endif // JQ_DEBUG
 
 }
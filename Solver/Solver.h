@@ -11,15 +11,22 @@
 #include "Config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <functional>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include "Common.h"
 #include "Utility.h"
 #include "LogSwitch.h"
 #include "Problem.h"
+#include "Geometry.h"
 
 
 namespace szx {
@@ -27,6 +34,10 @@ namespace szx {
 class Solver {
     #pragma region Type
 public:
+    struct Environment;
+    struct Configuration;
+    struct DistanceTable;
+
     // commmand line interface.
     struct Cli {
         static constexpr int MaxArgLen = 256;
@@ -42,30 +53,62 @@ public:
         static String EnvironmentPathOption() { return "-env"; }
         static String ConfigPathOption() { return "-cfg"; }
         static String LogPathOption() { return "-log"; }
+        static String CheckpointPathOption() { return "-ckpt"; }
+        static String ResumePathOption() { return "-resume"; }
+        static String InitSolutionPathOption() { return "-init"; }
+        static String TargetOption() { return "-target"; }
+        static String CenterNumOption() { return "-centers"; }
+        static String ProgressPathOption() { return "-progress"; }
+        static String BatchPathOption() { return "-batch"; }
+        static String SummaryPathOption() { return "-summary"; }
+        static String DaemonPathOption() { return "-daemon"; }
+        static String CenterRangeOption() { return "-p-range"; }
 
         static String AuthorNameSwitch() { return "-name"; }
+        static String ProgressCentersSwitch() { return "-progressCenters"; }
         static String HelpSwitch() { return "-h"; }
 
         static String AuthorName() { return "szx"; }
         static String HelpInfo() {
             return "Pattern (args can be in any order):\n"
                 "  exe (-p path) (-o path) [-s int] [-t seconds] [-name]\n"
+                "  exe (-batch path) [-summary path] [-j int]\n"
+                "  exe (-daemon path)\n"
+                "  exe (-p path) (-o path) (-p-range int:int) [-j int]\n"
                 "      [-iter int] [-j int] [-id string] [-h]\n"
                 "      [-env path] [-cfg path] [-log path]\n"
+                "      [-ckpt path] [-resume path] [-init path] [-target int]\n"
+                "      [-centers int] [-progress path] [-progressCenters]\n"
                 "Switches:\n"
                 "  -name  return the identifier of the authors.\n"
                 "  -h     print help information.\n"
+                "  -progressCenters  include the centers in the improvements of the progress stream.\n"
                 "Options:\n"
-                "  -p     input instance file path.\n"
+                "  -p     input instance file path (.json, .bin, OR-Library .txt or TSPLIB .tsp).\n"
                 "  -o     output solution file path.\n"
                 "  -s     rand seed for the solver.\n"
-                "  -t     max running time of the solver.\n"
+                "  -t     max running time of the solver (60 seconds by default).\n"
                 "  -i     max iteration of the solver.\n"
                 "  -j     max number of working solvers at the same time.\n"
                 "  -rid   distinguish different runs in log file and output.\n"
                 "  -env   environment file path.\n"
                 "  -cfg   configuration file path.\n"
                 "  -log   activate logging and specify log file path.\n"
+                "  -ckpt  periodically save the search state of worker i to path.i.\n"
+                "  -resume  restore the search state of worker i from path.i.\n"
+                "  -init  start from the solution file saved by a previous run.\n"
+                "  -target  stop all workers once the objective is not greater than it.\n"
+                "  -centers  number of centers. it overrides the one in the instance\n"
+                "         and is required by TSPLIB instances.\n"
+                "  -progress  write the improvements and heartbeats as JSON lines to path\n"
+                "         (- for stdout).\n"
+                "  -batch  solve the jobs in the manifest over a pool of -j threads.\n"
+                "         each line is \"instance;seed;timeout;solution[;centers]\",\n"
+                "         where the seed, timeout and centers can be left empty.\n"
+                "  -summary  CSV file path of the objectives in batch mode.\n"
+                "  -daemon  serve the requests on the Unix domain socket at path.\n"
+                "  -p-range  solve for each number of centers in the closed range and\n"
+                "         write the radius curve as CSV to the -o path. -t applies to each.\n"
                 "Note:\n"
                 "  0. in pattern, () is non-optional group, [] is optional group\n"
                 "     when -env option is not given.\n"
@@ -79,8 +122,25 @@ public:
                 "     is not guaranteed to be feasible.\n";
         }
 
-        // a dummy main function.
+        // a dummy main function. SIGINT and SIGTERM stop the search and the best solution is still saved.
         static int run(int argc, char *argv[]);
+
+        // solve the instance and save the solution. the distance table is built if it is not given.
+        // it returns the objective, or -1 if no solution is found.
+        static Length solve(const Problem::Input &input, const Environment &env, const Configuration &cfg,
+            std::shared_ptr<const DistanceTable> table = nullptr);
+        // solve each job with a single thread. the largest instances are solved first to minimize the makespan,
+        // and the jobs on the same instance share a single copy of it and its distance table.
+        // it returns the number of failed jobs, or -1 on IO error.
+        static int runBatch(const String &manifestPath, const String &summaryPath, const Environment &env, const Configuration &cfg);
+        // solve the instance for each number of centers in "a:b" sharing a single distance table. the range is split
+        // into env.jobNum contiguous chunks, and each number warm-starts from the solution of the previous one in its chunk.
+        // it returns the number of failed ones, or -1 on invalid range or IO error.
+        static int runSweep(const Problem::Input &input, const String &range, const Environment &env, const Configuration &cfg);
+
+
+        // cancelled by SIGINT or SIGTERM after run() installs the handlers. the solvers started by the CLI are linked to it.
+        static CancellationToken interruption;
     };
 
     // controls the I/O data format, exported contents and general usage of the solver.
@@ -98,38 +158,53 @@ public:
             String threadNum(std::to_string(threadNumPerWorker));
             std::ostringstream oss;
             oss << "alg=" << alg
-                << ";job=" << threadNum;
+                << ";job=" << threadNum
+                << ";cons=" << constructionNum;
             return oss.str();
         }
 
 
         Algorithm alg = Configuration::Algorithm::Greedy; // OPTIMIZE[szx][3]: make it a list to specify a series of algorithms to be used by each threads in sequence.
         int threadNumPerWorker = (std::min)(1, static_cast<int>(std::thread::hardware_concurrency()));
+        int constructionNum = 64; // number of initial solutions built before the local search.
+        int maxMatrixNodeNum = 4096; // compute the distances on demand for larger geometric instances.
+        int nearestNum = 256; // length of the nearest lists if the distances are computed on demand.
+        Duration msCheckpointInterval = 60 * static_cast<Duration>(Timer::MillisecondsPerSecond);
+        Duration msSolutionSaveInterval = 1 * static_cast<Duration>(Timer::MillisecondsPerSecond); // min interval between two writes of the best solution.
+        Duration msProgressInterval = 1 * static_cast<Duration>(Timer::MillisecondsPerSecond); // interval between two heartbeats in the progress stream.
+        int cacheSizeInMegabytes = 1024; // the least recently used instances are dropped beyond it in daemon mode.
     };
 
     // describe the requirements to the input and output data interface.
     struct Environment {
-        static constexpr int DefaultTimeout = (1 << 30);
+        static constexpr int DefaultTimeout = 60; // in seconds. every entry point without a time budget stops by it.
         static constexpr int DefaultMaxIter = (1 << 30);
         static constexpr int DefaultJobNum = 0;
-        // preserved time for IO in the total given time.
-        static constexpr int SaveSolutionTimeInMillisecond = 1000;
+        static constexpr Length DefaultTarget = -1; // never reached since the objective is non-negative.
+        static constexpr int DefaultCenterNum = 0; // use the one in the instance.
 
         static constexpr Duration RapidModeTimeoutThreshold = 600 * static_cast<Duration>(Timer::MillisecondsPerSecond);
 
+        // saturate instead of overflowing, e.g., (1 << 30) seconds becomes about 24.8 days.
+        static Duration toMilliseconds(double second) {
+            double ms = second * Timer::MillisecondsPerSecond;
+            return (ms < (std::numeric_limits<Duration>::max)()) ? static_cast<Duration>(ms) : (std::numeric_limits<Duration>::max)();
+        }
+
         static String DefaultInstanceDir() { return "Instance/"; }
         static String DefaultSolutionDir() { return "Solution/"; }
         static String DefaultVisualizationDir() { return "Visualization/"; }
         static String DefaultEnvPath() { return "env.csv"; }
         static String DefaultCfgPath() { return "cfg.csv"; }
         static String DefaultLogPath() { return "log.csv"; }
+        static String DefaultSummaryPath() { return "summary.csv"; }
 
         Environment(const String &instancePath, const String &solutionPath,
             int randomSeed = Random::generateSeed(), double timeoutInSecond = DefaultTimeout,
             Iteration maxIteration = DefaultMaxIter, int jobNumber = DefaultJobNum, String runId = "",
             const String &cfgFilePath = DefaultCfgPath(), const String &logFilePath = DefaultLogPath())
             : instPath(instancePath), slnPath(solutionPath), randSeed(randomSeed),
-            msTimeout(static_cast<Duration>(timeoutInSecond * Timer::MillisecondsPerSecond)), maxIter(maxIteration),
+            msTimeout(toMilliseconds(timeoutInSecond)), maxIter(maxIteration),
             jobNum(jobNumber), rid(runId), cfgPath(cfgFilePath), logPath(logFilePath), localTime(Timer::getTightLocalTime()) {}
         Environment() : Environment("", "") {}
 
@@ -141,6 +216,8 @@ public:
         void calibrate(); // adjust job number and timeout to fit the platform.
 
         String solutionPathWithTime() const { return slnPath + "." + localTime; }
+        String checkpointPath(ID workerId) const { return ckptPath + "." + std::to_string(workerId); }
+        String resumePath(ID workerId) const { return rsmPath + "." + std::to_string(workerId); }
 
         String visualizPath() const { return DefaultVisualizationDir() + friendlyInstName() + "." + localTime + ".html"; }
         template<typename T>
@@ -166,6 +243,13 @@ public:
         String rid; // the id of each run.
         String cfgPath;
         String logPath;
+        String ckptPath; // save checkpoints if it is not empty.
+        String rsmPath; // resume from checkpoints if it is not empty.
+        String initPath; // start from this solution if it is not empty.
+        Length target = DefaultTarget; // stop once the objective is not greater than it.
+        int centerNum = DefaultCenterNum; // override the number of centers in the instance if it is positive.
+        String progressPath; // write the progress stream if it is not empty. "-" is stdout.
+        bool progressCenters = false; // include the centers in the improvements of the progress stream.
 
         // auto-generated data.
         String localTime;
@@ -176,6 +260,254 @@ public:
 
         Solver *solver;
     };
+
+    // an initial solution generated in the construction stage.
+    struct Construction {
+        List<ID> centers; // zero-based node IDs.
+        Length maxLength;
+    };
+
+    // the distances and ranks only depend on the graph, so they can be shared by the solvers on the same
+    // instance, e.g., with different seeds or number of centers. it is read only after it is built.
+    struct DistanceTable {
+        List<List<Length>> dist; // dist[u][v] is the length of the shortest path between node u and v.
+        // the row-major matrix of the input is used in place of dist if it is given, e.g., by a mapped binary instance.
+        const Length *matrix = nullptr;
+        size_t matrixNodeNum = 0;
+        std::shared_ptr<const void> matrixStorage; // keep the matrix valid.
+        DistanceOracle oracle; // dist is empty and the oracle computes the distances for large geometric instances.
+        // nearest[u] is all nodes sorted by their distance to node u in ascending order.
+        // only the cfg.nearestNum nearest nodes are ranked if the distances are computed on demand.
+        List<List<ID>> nearest;
+
+        bool isOnDemand() const { return dist.empty() && !matrix; }
+        const Length* row(ID u) const { return matrix ? (matrix + u * matrixNodeNum) : dist[u].data(); }
+        size_t memoryUsage() const; // in bytes.
+    };
+
+    struct Auxiliary { // auxiliary data for solver. it is read only after init().
+        int nodeNum;
+        int centerNum;
+        std::shared_ptr<const DistanceTable> table; // it is built in init() unless it is given.
+        // nearest[u] is the candidates in table->nearest[u], i.e., the dominated nodes are removed in reduce().
+        List<List<ID>> nearest;
+        List<bool> isCandidate; // isCandidate[u] is false if node u is dominated by another candidate.
+        Length lowerBound; // the optimal radius is proved to be in [lowerBound, upperBound].
+        Length upperBound;
+        List<Construction> initSlns; // initSlns[w] is the starting point of worker w.
+
+        bool isOnDemand() const { return table->isOnDemand(); }
+        Length distance(ID u, ID v) const { return isOnDemand() ? table->oracle(u, v) : table->row(u)[v]; }
+        // the distances from node u to all nodes. they are computed into buf if they are on demand.
+        const Length* distances(ID u, List<Length> &buf) const {
+            if (!isOnDemand()) { return table->row(u); }
+            buf.resize(nodeNum);
+            table->oracle.row(u, buf.data());
+            return buf.data();
+        }
+    };
+
+    // write each new global best to the solution path in the background, so that a killed run still leaves
+    // a valid solution. the search threads only copy the centers, and the file is written at most once per
+    // cfg.msSolutionSaveInterval. the final solution is saved by the caller, so the pending one is dropped on stop.
+    class SolutionWriter {
+    public:
+        SolutionWriter(Solver &ownerSolver) : solver(ownerSolver) {}
+        ~SolutionWriter() { stop(); }
+
+        void start();
+        void stop();
+
+        // take a snapshot if it is better than all the previous ones.
+        void offer(Length maxLength, const List<ID> &centers);
+
+    protected:
+        void run();
+        bool write(Length maxLength, const List<ID> &centers) const;
+
+
+        Solver &solver;
+        std::atomic<Length> bestMaxLength = { INT32_MAX }; // reject the worse ones without locking.
+
+        std::mutex snapshotMutex;
+        std::condition_variable snapshotCond;
+        Length pendingMaxLength = INT32_MAX;
+        List<ID> pendingCenters; // zero-based node IDs.
+        bool hasPending = false;
+        bool isStopped = true;
+
+        std::thread writer;
+    };
+
+    // opt-in JSON lines of the search progress. each worker pushes its improvements into its own lock-free queue
+    // and publishes its iteration counter, then a single emitter thread writes the new global bests in time order
+    // and a throughput heartbeat every cfg.msProgressInterval, so the workers never wait for the output.
+    class ProgressStream {
+    public:
+        static constexpr int QueueCapacity = 256; // the improvements are dropped if the emitter falls behind.
+        static constexpr Duration PollIntervalInMillisecond = 50;
+
+
+        ProgressStream(Solver &ownerSolver) : solver(ownerSolver) {}
+        ~ProgressStream() { stop(); }
+
+        void start(int workerNum); // nothing is written if env.progressPath is empty and there is no sink.
+        void stop(); // write the remaining events and a final heartbeat.
+
+        // pass each line without line ending to the sink instead of writing to env.progressPath.
+        void redirect(std::function<void(const String &line)> lineSink) { sink = lineSink; }
+
+        // the following methods are called by the given worker only.
+        void improve(ID workerId, Iteration iteration, Length maxLength, const List<ID> &centers);
+        void count(ID workerId, Iteration iteration) {
+            if (channels.empty()) { return; }
+            channels[workerId].iteration.store(iteration, std::memory_order_relaxed);
+        }
+
+    protected:
+        struct Event {
+            double time; // in seconds.
+            ID workerId;
+            Iteration iteration;
+            Length maxLength;
+            List<ID> centers; // zero-based node IDs. it is empty if env.progressCenters is false.
+        };
+
+        struct alignas(64) Channel { // owned by a single worker.
+            SpscQueue<Event> events{ QueueCapacity };
+            std::atomic<Iteration> iteration = { 0 };
+            std::atomic<int> dropNum = { 0 };
+        };
+
+
+        void run();
+        void drain(); // write the global bests among the queued events.
+        void heartbeat(const char *eventName);
+        void write(const String &line);
+
+
+        Solver &solver;
+        List<Channel> channels; // channels[w] is written by worker w only.
+        std::function<void(const String &line)> sink;
+        std::ofstream ofs;
+        std::ostream *os = nullptr;
+
+        // only accessed by the emitter thread after start().
+        List<Event> events;
+        Length bestMaxLength = INT32_MAX;
+        Iteration lastIteration = 0;
+        double lastTime = 0;
+
+        std::mutex stopMutex;
+        std::condition_variable stopCond;
+        bool isStopped = true;
+
+        std::thread emitter;
+    };
+
+    // the search state of a single worker. workers only share the read-only auxiliary data,
+    // so they can run concurrently without any synchronization.
+    class Worker {
+    public:
+        // check the clock for checkpointing every (CheckIterMask + 1) iterations.
+        static constexpr Iteration CheckIterMask = (1 << 10) - 1;
+        // check the clock for the deadline every (DeadlineCheckIterMask + 1) iterations.
+        // the cancellation is checked in every iteration since it is a single relaxed load.
+        static constexpr Iteration DeadlineCheckIterMask = (1 << 4) - 1;
+
+
+        Worker(Solver &ownerSolver, ID workerId, const Random &randomGenerator)
+            : solver(ownerSolver), aux(ownerSolver.aux), id(workerId), rand(randomGenerator) {}
+
+        void init(const List<ID> &initCenters); // build f/d tables from the given centers.
+        void search(Iteration maxIter); // swap-based tabu search.
+
+        // the checkpoint keeps the centers, iteration, random state and tabu entries,
+        // and the tables are rebuilt from the centers on loading.
+        bool saveCheckpoint(const String &path) const;
+        bool loadCheckpoint(const String &path, Length *lowerBound = nullptr, Length *upperBound = nullptr);
+
+        Length getMaxLength() const { return bestMaxLength; }
+        const List<ID>& getCenters() const { return bestCenters; }
+
+    protected:
+        #if JQ_DEBUG
+        // shadow the d table of a worker and verify it after each move. only the nodes served by the added or
+        // deleted center are recomputed from the distances in O(p), and all nodes are recomputed every
+        // FullVerifyInterval moves. the distances are compared instead of the centers since there may be ties.
+        class DeltaVerifier {
+        public:
+            static constexpr int FullVerifyInterval = 256;
+            static constexpr int HistoryLength = 16;
+            static constexpr int MaxReportNum = 8; // stop reporting since the later moves inherit the errors.
+
+            void reset(const Worker &worker); // recompute the shadow tables from the centers of the worker.
+            void verify(const Worker &worker, ID node, bool isAdded); // call it after the worker updates its tables.
+
+        protected:
+            struct Move {
+                Iteration iteration;
+                ID node;
+                bool isAdded;
+            };
+
+            void recompute(const Worker &worker, ID v);
+            void report(const Worker &worker, ID v, const String &reason);
+
+            List<bool> isCenter;
+            List<ID> centers;
+            List<List<Length>> dTable;
+            List<Length> distBuf;
+            List<ID> touchedNodes;
+            List<Move> history; // ring buffer of the recent moves.
+            long long moveNum = 0;
+            int reportNum = 0;
+        };
+        #endif // JQ_DEBUG
+
+        void addNodeToTable(ID node);//ӷڵ㲢fd
+        void deleteNodeInTable(ID node);//ɾڵ㲢fd
+        void findNext(ID v);//ѰҴνڵ㲢fd
+        List<ID> findSeveredNodeNeighbourhood();//ѡڵ
+        List<ID> sortIndexes(ID node, int k, Length length);//ǰkСֵӦֵ
+        List<List<int>> findPair(const List<ID> &alternativeNode, int t);//(f,v)fΪӵĽڵ㣬vΪɾĽڵ
+        long long tabuKey(ID f, ID v) const { return static_cast<long long>(f) * aux.nodeNum + v; }
+        Iteration tenure(ID f, ID v) const {
+            if (!tableTenure.empty()) { return tableTenure[tabuKey(f, v)]; }
+            auto t = sparseTenure.find(tabuKey(f, v));
+            return (t == sparseTenure.end()) ? 0 : t->second;
+        }
+        void setTenure(ID f, ID v, Iteration t) {
+            if (tableTenure.empty()) { sparseTenure[tabuKey(f, v)] = t; } else { tableTenure[tabuKey(f, v)] = t; }
+        }
+        void clearTenure(); // drop all tabu entries.
+
+
+        Solver &solver;
+        const Auxiliary &aux;
+        ID id;
+        Random rand;
+        Iteration iteration = 0;
+
+        int kClosed = 50;
+        int step_tenure = 15;
+        Length maxLength = 0;
+        Length hist_maxLength = 0;
+        List<List<int>> fTable, dTable;
+        // tableTenure[tabuKey(f, v)] is the tenure of swapping in f for v. it is as large as the distance matrix, so the
+        // unexpired entries are kept in sparseTenure instead if the distances are computed on demand.
+        List<Iteration> tableTenure;
+        std::unordered_map<long long, Iteration> sparseTenure;
+        List<Length> distBuf;
+        List<bool> isServerdNode;
+        List<ID> centers;
+        Length bestMaxLength = INT32_MAX;
+        List<ID> bestCenters;
+
+        #if JQ_DEBUG
+        DeltaVerifier verifier;
+        #endif // JQ_DEBUG
+    };
     #pragma endregion Type
 
     #pragma region Constant
@@ -186,7 +518,8 @@ public:
 public:
     Solver(const Problem::Input &inputData, const Environment &environment, const Configuration &config)
         : input(inputData), env(environment), cfg(config), rand(environment.randSeed),
-        timer(std::chrono::milliseconds(environment.msTimeout)), iteration(1) {}
+        timer(std::chrono::milliseconds(environment.msTimeout)), iteration(1), targetReached(false), timeToTarget(-1),
+        solutionWriter(*this), progress(*this) {}
     #pragma endregion Constructor
 
     #pragma region Method
@@ -195,47 +528,78 @@ public:
     bool check(Length &obj) const;
     void record() const; // save running log.
 
-private:
-	std::vector<std::vector<int>> G;
-	int kClosed = 50;
-	int maxLength = 0;
-	int hist_maxLength = 0;
-	int nodeNum;
-	int edgeNum;
-	int centerNum;
-	int step_tenure = 15;
-	std::vector<std::vector<int>> tableTenure;
-	std::vector<bool> isServerdNode;
-	std::vector<int> centers;
+    // all-pairs shortest path lengths on the graph of the input. INF means unreachable.
+    // the matrix of the input is copied as it is if it is available.
+    static void shortestPaths(const Problem::Input &input, List<List<Length>> &dist);
+    // compute the distance matrix, or borrow the one of the input, and rank the nearest nodes with threadNum threads.
+    // for large geometric instances, only the cfg.nearestNum nearest nodes are ranked by the spatial index instead.
+    static void buildDistanceTable(const Problem::Input &input, const Configuration &cfg, int threadNum, DistanceTable &table);
+    // replace the edges between the node pairs in delta, or remove them if the length is negative, then repair the
+    // table built on the original graph. the shorter edges are relaxed through all pairs (Ausiello et al., 1991),
+    // and only the sources with a shortest path over a longer edge are recomputed by Dijkstra's algorithm.
+    // it returns false if the distances are not given by a graph.
+    static bool updateGraph(Problem::Input &input, const List<Problem::Edge> &delta, DistanceTable &table);
+
 protected:
     void init();
     bool optimize(Solution &sln, ID workerId = 0); // optimize by a single worker.
-	std::vector<std::vector<int>> fTable, dTable;
-	void addNodeToTable(int node);//ӷڵ㲢fd
-	void deleteNodeInTable( int node);//ɾڵ㲢fd
-	void findNext(int v);//ѰҴνڵ㲢fd
-	int selectNextSeveredNode();//ѡڵ
-	std::vector<int> findSeveredNodeNeighbourhood();//ѡڵ
-	std::vector<int> sortIndexes(const std::vector<int> &v, int k, int length);//ǰkСֵӦֵ
-	std::vector<std::vector<int>> findPair(const std::vector<int> &alternativeNode, int t);//(f,v)fΪӵĽڵ㣬vΪɾĽڵ
+
+    // build cfg.constructionNum initial solutions in parallel and keep the best ones for workers.
+    void construct(int workerNum);
+    // farthest-first traversal (Gonzalez, 1985). the next center is the farthest node itself
+    // if `onFarthest` is true, or a random node among its neighbors which are closer to it.
+    // it starts from a random node if sln.centers is empty, or completes the given centers.
+    void construct(Construction &sln, Random &r, bool onFarthest) const;
+
+    // replace the initial solutions with initCenters or the one in env.initPath.
+    // the extra centers are dropped by shrink() and the missing ones are added by construct().
+    // it also sets the bounds, so construct(workerNum) is skipped if it returns true.
+    bool warmStart(int workerNum);
+    // drop the center whose removal enlarges the radius least until there are aux.centerNum centers.
+    void shrink(Construction &sln) const;
+    // load the bounds and initial solutions from the checkpoints instead of constructing.
+    bool resume(int workerNum);
+
+    // drop the duplicated and dominated candidates for radii in [aux.lowerBound, aux.upperBound].
+    void reduce();
+    // return true if replacing center u with w never enlarges the radius in the bounds.
+    bool dominate(ID w, ID u) const;
+
+    // notify all workers to stop and record the time to target for the first caller.
+    void reachTarget();
+    bool isCancelled() const { return cancellation.isCancelled(); }
+
+    // all workers get non-overlapping random streams derived from the same seed.
+    Random randomStream(int streamId) const;
     #pragma endregion Method
 
 
     #pragma region Field
 public:
-    Problem::Input input;
+    // it is not copied, so that the solvers on the same instance, e.g., in batch mode, share a single loaded copy.
+    // the caller keeps it alive until solve() returns, and env.centerNum overrides its number of centers.
+    const Problem::Input &input;
     Problem::Output output;
 
-    struct { // auxiliary data for solver.
-        List<List<bool>> isCompatible; // isCompatible[f][g] is true if flight f is compatible with gate g.
-    } aux;
+    Auxiliary aux;
 
     Environment env;
     Configuration cfg;
 
+    List<ID> initCenters; // zero-based node IDs. start from them instead of env.initPath if it is not empty.
+    // all workers stop with their best solutions once it is cancelled, i.e., on timeout, on reaching the target,
+    // or by the parent token linked by the caller.
+    CancellationToken cancellation;
+
     Random rand; // all random number in Solver must be generated by this.
     Timer timer; // the solve() should return before it is timeout.
     Iteration iteration;
+
+    std::atomic<bool> targetReached;
+    double timeToTarget; // in seconds. it is negative if the target is not reached.
+
+    SolutionWriter solutionWriter;
+    ProgressStream progress;
     #pragma endregion Field
 }; // Solver 
 
@@ -4,6 +4,12 @@
 #include <Windows.h>
 #include <Psapi.h>
 #else
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 // EXTEND[szx][9]: get memory usage on *nix.
 #endif // _OS_MS_WINDOWS
 
@@ -13,6 +19,92 @@ using namespace std;
 
 namespace szx {
 
+bool System::moveFile(const string &srcPath, const string &dstPath) {
+    #if _OS_MS_WINDOWS
+    return MoveFileExA(srcPath.c_str(), dstPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    #else
+    return rename(srcPath.c_str(), dstPath.c_str()) == 0; // rename() replaces the destination atomically on POSIX.
+    #endif // _OS_MS_WINDOWS
+}
+
+bool System::listFiles(const string &dir, vector<string> &paths) {
+    paths.clear();
+    string prefix(dir);
+    if (!prefix.empty() && (prefix.back() != '/') && (prefix.back() != '\\')) { prefix += '/'; }
+
+    #if _OS_MS_WINDOWS
+    WIN32_FIND_DATAA entry;
+    HANDLE finder = FindFirstFileA((prefix + "*").c_str(), &entry);
+    if (finder == INVALID_HANDLE_VALUE) { return false; }
+    do {
+        if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) { paths.push_back(prefix + entry.cFileName); }
+    } while (FindNextFileA(finder, &entry));
+    FindClose(finder);
+    #else
+    DIR *d = opendir(dir.c_str());
+    if (!d) { return false; }
+    for (dirent *entry; (entry = readdir(d)) != nullptr;) {
+        string path(prefix + entry->d_name);
+        struct stat info;
+        if ((stat(path.c_str(), &info) == 0) && S_ISREG(info.st_mode)) { paths.push_back(path); }
+    }
+    closedir(d);
+    #endif // _OS_MS_WINDOWS
+
+    sort(paths.begin(), paths.end());
+    return true;
+}
+
+bool MemoryMappedFile::open(const string &path) {
+    close();
+
+    #if _OS_MS_WINDOWS
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart <= 0)) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps the file open.
+    if (mapping == nullptr) { return false; }
+    void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive.
+    if (addr == nullptr) { return false; }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    #else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        ::close(fd);
+        return false;
+    }
+    void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file open.
+    if (addr == MAP_FAILED) { return false; }
+    length = static_cast<size_t>(st.st_size);
+    #endif // _OS_MS_WINDOWS
+
+    view = static_cast<const char*>(addr);
+    return true;
+}
+
+void MemoryMappedFile::close() {
+    if (view == nullptr) { return; }
+
+    #if _OS_MS_WINDOWS
+    UnmapViewOfFile(view);
+    #else
+    munmap(const_cast<char*>(view), length);
+    #endif // _OS_MS_WINDOWS
+
+    view = nullptr;
+    length = 0;
+}
+
 System::MemoryUsage System::memoryUsage() {
     MemoryUsage mu = { 0, 0 };
 
@@ -11,6 +11,7 @@
 #include "Config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <initializer_list>
 #include <vector>
@@ -19,6 +20,7 @@
 #include <iostream>
 #include <iomanip>
 
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
 #include <ctime>
@@ -276,39 +278,144 @@ protected:
 };
 
 
-class Random {
+// xoshiro256** 1.0 by David Blackman and Sebastiano Vigna (http://xoshiro.di.unimi.it/).
+// it keeps 32 bytes of state instead of 2.5KB in std::mt19937 and is several times faster.
+class Xoshiro256StarStar {
 public:
-    using Generator = std::mt19937;
+    using result_type = std::uint64_t;
 
+    static constexpr int StateSize = 4;
 
-    Random(int seed) : rgen(seed) {}
-    Random() : rgen(generateSeed()) {}
+
+    explicit Xoshiro256StarStar(result_type seedValue = 0) { seed(seedValue); }
+
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    // expand the seed with splitmix64 so that the state will never be all zero.
+    void seed(result_type seedValue) {
+        for (int i = 0; i < StateSize; ++i) {
+            seedValue += 0x9e3779b97f4a7c15;
+            result_type z = seedValue;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()() {
+        result_type result = rotl(state[1] * 5, 7) * 9;
+        result_type t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    void discard(unsigned long long n) { for (; n > 0; --n) { (*this)(); } }
+
+    // equivalent to 2^128 calls to operator()(). it generates 2^128 non-overlapping
+    // subsequences of length 2^128 for parallel computations.
+    void jump() {
+        static constexpr result_type JumpPoly[StateSize] = {
+            0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+
+        result_type s[StateSize] = { 0, 0, 0, 0 };
+        for (int i = 0; i < StateSize; ++i) {
+            for (int b = 0; b < 64; ++b) {
+                if (JumpPoly[i] & (static_cast<result_type>(1) << b)) {
+                    for (int j = 0; j < StateSize; ++j) { s[j] ^= state[j]; }
+                }
+                (*this)();
+            }
+        }
+        std::copy(s, s + StateSize, state);
+    }
+
+    friend bool operator==(const Xoshiro256StarStar &l, const Xoshiro256StarStar &r) {
+        return std::equal(l.state, l.state + StateSize, r.state);
+    }
+    friend bool operator!=(const Xoshiro256StarStar &l, const Xoshiro256StarStar &r) { return !(l == r); }
+
+
+    result_type state[StateSize];
+
+protected:
+    static result_type rotl(result_type x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// the engine can be any generator which produces full 32-bit or 64-bit unsigned integers,
+// e.g., Xoshiro256StarStar, std::mt19937 or std::mt19937_64.
+template<typename RandomEngine = Xoshiro256StarStar>
+class BasicRandom {
+public:
+    using Generator = RandomEngine;
+
+
+    BasicRandom(int seed) : rgen(seed) {}
+    BasicRandom() : rgen(generateSeed()) {}
 
 
     static int generateSeed() {
         return static_cast<int>(std::time(nullptr) + std::clock());
     }
 
-    Generator::result_type operator()() { return rgen(); }
+    typename Generator::result_type operator()() { return rgen(); }
 
     // pick with probability of (numerator / denominator).
     bool isPicked(unsigned numerator, unsigned denominator) {
-        return ((rgen() % denominator) < numerator);
+        return (bounded(denominator) < numerator);
     }
 
     // pick from [min, max).
     int pick(int min, int max) {
-        return ((rgen() % (max - min)) + min);
+        return (static_cast<int>(bounded(static_cast<std::uint32_t>(max - min))) + min);
     }
     // pick from [0, max).
     int pick(int max) {
-        return (rgen() % max);
+        return static_cast<int>(bounded(static_cast<std::uint32_t>(max)));
+    }
+
+    // move this stream 2^128 steps ahead (only available if the engine provides jump()).
+    void jump() { rgen.jump(); }
+    // return the current stream and jump to the next one. calling it once for each worker
+    // gives non-overlapping streams to all workers with a single seed.
+    BasicRandom split() {
+        BasicRandom r(*this);
+        jump();
+        return r;
     }
 
 
     Generator rgen;
+
+protected:
+    static constexpr int HighBitShift = (Generator::max() > UINT32_MAX) ? 32 : 0;
+
+    std::uint32_t next32() { return static_cast<std::uint32_t>(rgen() >> HighBitShift); }
+
+    // unbiased sampling from [0, range) by Lemire's multiply-shift method which avoids
+    // the division in most cases (Fast Random Integer Generation in an Interval, 2019).
+    std::uint32_t bounded(std::uint32_t range) {
+        std::uint64_t m = static_cast<std::uint64_t>(next32()) * range;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < range) {
+            std::uint32_t threshold = (0u - range) % range;
+            while (low < threshold) {
+                m = static_cast<std::uint64_t>(next32()) * range;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
 };
 
+using Random = BasicRandom<>;
+
 // count | 1 2 3 4 ...  k   k+1   k+2   k+3  ...  n
 // ------|------------------------------------------
 // index | 0 1 2 3 ... k-1   k    k+1   k+2  ... n-1
@@ -652,6 +759,61 @@ struct Interval {
 };
 
 
+// bounded lock-free queue between one producer thread and one consumer thread.
+// neither push() nor pop() blocks, and the items are moved into the preallocated slots.
+template<typename T>
+class SpscQueue {
+public:
+    SpscQueue(size_t capacity = 1024) : slots(capacity + 1) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // return false without taking the item if the queue is full.
+    bool push(T &&item) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t nextTail = (tail + 1) % slots.size();
+        if (nextTail == headIndex.load(std::memory_order_acquire)) { return false; }
+        slots[tail] = std::move(item);
+        tailIndex.store(nextTail, std::memory_order_release);
+        return true;
+    }
+    // return false if the queue is empty.
+    bool pop(T &item) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) { return false; }
+        item = std::move(slots[head]);
+        headIndex.store((head + 1) % slots.size(), std::memory_order_release);
+        return true;
+    }
+
+protected:
+    std::vector<T> slots; // one slot is always empty to tell a full queue from an empty one.
+    alignas(64) std::atomic<size_t> headIndex = { 0 }; // written by the consumer only.
+    alignas(64) std::atomic<size_t> tailIndex = { 0 }; // written by the producer only.
+};
+
+// cooperative stop signal shared by threads. the holders poll it by a relaxed load and stop by themselves.
+// a token is also cancelled once its parent is cancelled, so a caller can stop all the tokens linked to its own.
+class CancellationToken {
+public:
+    CancellationToken(const CancellationToken *parentToken = nullptr) : parent(parentToken) {}
+
+    // it is async-signal-safe if the atomic flag is lock-free.
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled.store(false, std::memory_order_relaxed); }
+    bool isCancelled() const {
+        return cancelled.load(std::memory_order_relaxed) || (parent && parent->isCancelled());
+    }
+
+    // the parent should outlive this token.
+    void link(const CancellationToken *parentToken) { parent = parentToken; }
+
+protected:
+    std::atomic<bool> cancelled = { false };
+    const CancellationToken *parent;
+};
+
+
 class System {
 public:
     struct Shell {
@@ -687,6 +849,12 @@ public:
         exec(Cmd::Mkdir() + quote(dir) + Cmd::RedirectStderr() + Cmd::NullDev());
     }
 
+    // replace the destination file with the source file atomically if the platform supports.
+    static bool moveFile(const std::string &srcPath, const std::string &dstPath);
+
+    // the paths of the regular files directly in dir, sorted by name. it returns false if dir is not a directory.
+    static bool listFiles(const std::string &dir, std::vector<std::string> &paths);
+
     struct MemorySize {
         using Unit = long long;
 
@@ -717,6 +885,26 @@ public:
     static MemoryUsage peakMemoryUsage();
 };
 
+// read-only view of a whole file mapped into memory.
+// the pages are loaded on first access, and the view is valid until close() or destruction.
+class MemoryMappedFile {
+public:
+    MemoryMappedFile() {}
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+    ~MemoryMappedFile() { close(); }
+
+    bool open(const std::string &path);
+    void close();
+
+    const char* data() const { return view; }
+    size_t size() const { return length; }
+
+protected:
+    const char *view = nullptr;
+    size_t length = 0;
+};
+
 
 class Math {
 public: